@@ -0,0 +1,28 @@
+#include "bench.hpp"
+
+// bench-gen rows=1000000 shared=2 inline=0 ints=3 doubles=3 distinct=50 sparsity=0.2 seed=7
+// Write the “bench.xlsx” workbook, then time its reading and the generation of the “bench-data.hpp”
+// header by init. The report is written on the standard output, one JSON object by phase (and the
+// statistics of init).
+int
+main(int argc, char** argv)
+{
+
+	auto const spec{ bench::get_spec(argc, argv) };
+	// The progress messages of the library are not in the report, its statistics are.
+	xlsx2tcpp::set_progress(nullptr);
+	xlsx2tcpp::set_stats([](auto const& stats) { std::cout << stats.to_json() << std::endl; });
+	bench::Report report{ std::cout };
+
+	auto seconds{ report.time([&]() { bench::write_workbook("bench.xlsx", spec); }) };
+	auto const size{ bench::get_file_size("bench.xlsx") };
+	report.print("generate", spec.rows, size, seconds);
+
+	seconds = report.time([&]() { fd_read_xlsx::read("bench.xlsx"); });
+	report.print("fd_read_xlsx", spec.rows, size, seconds);
+
+	seconds = report.time([&]() { xlsx2tcpp::init("bench.xlsx"); });
+	report.print("init", spec.rows, size, seconds);
+
+	return 0;
+}
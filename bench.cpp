@@ -0,0 +1,31 @@
+#include "bench-data.hpp"
+#include "bench.hpp"
+
+// Time build, from the workbook then from its columns, and read on the “bench.xlsx” workbook
+// written by bench-gen. The report is written on the standard output, one JSON object by phase and one by
+// call with the statistics of the library.
+int
+main()
+{
+
+	xlsx2tcpp::set_progress(nullptr);
+	xlsx2tcpp::set_stats([](auto const& stats) { std::cout << stats.to_json() << std::endl; });
+	bench::Report report{ std::cout };
+	auto const size{ bench::get_file_size("bench.xlsx") };
+
+	// The workbook is parsed, then the columns stored by init are used.
+	auto seconds{ report.time([&]() {
+		xlsx2tcpp::build<Bench_data>("bench.xlsx", "", xlsx2tcpp::parse_source());
+	}) };
+	auto const rows{ xlsx2tcpp::read_manifest<Bench_data>("bench-data").n };
+	report.print("build", rows, size, seconds);
+
+	seconds = report.time([&]() { xlsx2tcpp::build<Bench_data>("bench.xlsx"); });
+	report.print("build_from_columns", rows, bench::get_file_size("bench-data.cols"), seconds);
+
+	std::vector<Bench_data> table;
+	seconds = report.time([&]() { table = xlsx2tcpp::read<Bench_data>(); });
+	report.print("read", table.size(), table.size() * sizeof(Bench_data), seconds);
+
+	return 0;
+}
@@ -0,0 +1,273 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+// The synthetic workbooks and the report of the benchmarks.
+
+#include "xlsx2tcpp.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <zip.h>
+
+namespace bench {
+
+typedef std::string str_t;
+
+// The shape of a workbook: the number of rows and the number of columns of each kind. The strings
+// are drawn from distinct values; a cell is empty with the probability sparsity.
+struct Spec
+{
+	size_t rows{ 100000 };
+	size_t shared{ 1 };
+	size_t inline_strings{ 1 };
+	size_t ints{ 2 };
+	size_t doubles{ 2 };
+	size_t distinct{ 100 };
+	double sparsity{ 0.1 };
+	uint64_t seed{ 1 };
+};
+
+// bench-gen rows=1000000 shared=2 inline=0 ints=3 doubles=3 distinct=50 sparsity=0.2 seed=7
+Spec
+get_spec(int argc, char** argv)
+{
+	Spec rvo;
+	for (int i{ 1 }; i < argc; ++i) {
+		str_t const arg{ argv[i] };
+		auto const pos{ arg.find('=') };
+		if (pos == str_t::npos)
+			throw xlsx2tcpp::Exception{ "the argument “" + arg + "” is not a “name=value” pair" };
+		auto const name{ arg.substr(0, pos) };
+		auto const value{ arg.substr(pos + 1) };
+		if (name == "rows")
+			rvo.rows = std::stoull(value);
+		else if (name == "shared")
+			rvo.shared = std::stoull(value);
+		else if (name == "inline")
+			rvo.inline_strings = std::stoull(value);
+		else if (name == "ints")
+			rvo.ints = std::stoull(value);
+		else if (name == "doubles")
+			rvo.doubles = std::stoull(value);
+		else if (name == "distinct")
+			rvo.distinct = std::max(size_t(1), size_t(std::stoull(value)));
+		else if (name == "sparsity")
+			rvo.sparsity = std::stod(value);
+		else if (name == "seed")
+			rvo.seed = std::stoull(value);
+		else
+			throw xlsx2tcpp::Exception{ "unknown argument “" + name + "”" };
+	}
+	return rvo;
+}
+
+// A, B, ..., Z, AA, AB...
+str_t
+get_column_name(size_t j)
+{
+	str_t rvo;
+	for (++j; j > 0; j = (j - 1) / 26)
+		rvo.insert(rvo.begin(), char('A' + (j - 1) % 26));
+	return rvo;
+}
+
+// Write the workbook with a single sheet, named “data”. The sheet is written in a temporary file,
+// which is zipped by libzip, so the memory does not depend on the number of rows.
+void
+write_workbook(char const* const file_name, Spec const& spec)
+{
+	str_t const ns{ "http://schemas.openxmlformats.org/" };
+	str_t const sheet_name{ str_t{ file_name } + ".sheet.tmp" };
+	{
+		std::ofstream sheet{ sheet_name, std::ios::binary };
+		if (!sheet)
+			throw xlsx2tcpp::Exception{ "unable to open for output the “" + sheet_name + "” file" };
+		std::mt19937_64 gen{ spec.seed };
+		std::uniform_real_distribution<double> uniform{ 0, 1 };
+		std::uniform_int_distribution<size_t> value{ 0, spec.distinct - 1 };
+		std::uniform_int_distribution<int64_t> integer{ -1000000, 1000000 };
+		sheet << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+		      << "<worksheet xmlns=\"" << ns << "spreadsheetml/2006/main\"><sheetData>";
+		for (size_t i{ 0 }; i <= spec.rows; ++i) {
+			auto const r{ std::to_string(i + 1) };
+			sheet << "<row r=\"" << r << "\">";
+			size_t j{ 0 };
+			auto const cell{ [&](char const* kind, size_t n, auto const& write) {
+				for (size_t k{ 0 }; k < n; ++k, ++j)
+					if (i == 0)
+						sheet << "<c r=\"" << get_column_name(j) << r << "\" t=\"inlineStr\"><is><t>" << kind
+						      << '_' << k + 1 << "</t></is></c>";
+					else if (uniform(gen) >= spec.sparsity) {
+						sheet << "<c r=\"" << get_column_name(j) << r << '"';
+						write();
+						sheet << "</c>";
+					}
+			} };
+			cell("shared", spec.shared, [&]() { sheet << " t=\"s\"><v>" << value(gen) << "</v>"; });
+			cell("inline", spec.inline_strings, [&]() {
+				sheet << " t=\"inlineStr\"><is><t>value_" << value(gen) << "</t></is>";
+			});
+			cell("int", spec.ints, [&]() { sheet << "><v>" << integer(gen) << "</v>"; });
+			cell("double", spec.doubles, [&]() {
+				char buffer[32];
+				std::snprintf(buffer, sizeof(buffer), "%.6f", 1000 * uniform(gen) + 0.5e-6);
+				sheet << "><v>" << buffer << "</v>";
+			});
+			sheet << "</row>";
+		}
+		sheet << "</sheetData></worksheet>";
+		if (!sheet.flush())
+			throw xlsx2tcpp::Exception{ "unable to write the “" + sheet_name + "” file" };
+	}
+
+	str_t const xml{ "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n" };
+	str_t const type{ "application/vnd.openxmlformats-officedocument.spreadsheetml." };
+	str_t shared_strings{ xml + "<sst xmlns=\"" + ns + "spreadsheetml/2006/main\">" };
+	for (size_t k{ 0 }; k < spec.distinct; ++k)
+		shared_strings += "<si><t>shared_" + std::to_string(k) + "</t></si>";
+	shared_strings += "</sst>";
+	// The buffers must live until the archive is closed.
+	std::deque<std::pair<char const*, str_t>> const parts{
+		{ "[Content_Types].xml",
+		  xml + "<Types xmlns=\"" + ns + "package/2006/content-types\">" +
+		    "<Default Extension=\"rels\" " +
+		    "ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>" +
+		    "<Default Extension=\"xml\" ContentType=\"application/xml\"/>" +
+		    "<Override PartName=\"/xl/workbook.xml\" ContentType=\"" + type + "sheet.main+xml\"/>" +
+		    "<Override PartName=\"/xl/worksheets/sheet1.xml\" ContentType=\"" + type +
+		    "worksheet+xml\"/>" + "<Override PartName=\"/xl/sharedStrings.xml\" ContentType=\"" +
+		    type + "sharedStrings+xml\"/>" + "</Types>" },
+		{ "_rels/.rels",
+		  xml + "<Relationships xmlns=\"" + ns + "package/2006/relationships\">" +
+		    "<Relationship Id=\"rId1\" Type=\"" + ns +
+		    "officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>" +
+		    "</Relationships>" },
+		{ "xl/workbook.xml",
+		  xml + "<workbook xmlns=\"" + ns + "spreadsheetml/2006/main\" xmlns:r=\"" + ns +
+		    "officeDocument/2006/relationships\"><sheets>" +
+		    "<sheet name=\"data\" sheetId=\"1\" r:id=\"rId1\"/></sheets></workbook>" },
+		{ "xl/_rels/workbook.xml.rels",
+		  xml + "<Relationships xmlns=\"" + ns + "package/2006/relationships\">" +
+		    "<Relationship Id=\"rId1\" Type=\"" + ns +
+		    "officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet1.xml\"/>" +
+		    "<Relationship Id=\"rId2\" Type=\"" + ns +
+		    "officeDocument/2006/relationships/sharedStrings\" Target=\"sharedStrings.xml\"/>" +
+		    "</Relationships>" },
+		{ "xl/sharedStrings.xml", shared_strings }
+	};
+
+	int error;
+	auto const archive{ zip_open(file_name, ZIP_CREATE | ZIP_TRUNCATE, &error) };
+	if (!archive)
+		throw xlsx2tcpp::Exception{ "unable to create the “" + str_t{ file_name } + "” workbook" };
+	auto const add{ [&](char const* name, zip_source_t* source) {
+		if (!source || (zip_file_add(archive, name, source, ZIP_FL_OVERWRITE) < 0)) {
+			if (source)
+				zip_source_free(source);
+			zip_discard(archive);
+			throw xlsx2tcpp::Exception{ "unable to add “" + str_t{ name } + "” to the “" +
+				                          str_t{ file_name } + "” workbook" };
+		}
+	} };
+	for (auto const& [name, contents] : parts)
+		add(name, zip_source_buffer(archive, contents.data(), contents.size(), 0));
+	add("xl/worksheets/sheet1.xml", zip_source_file(archive, sheet_name.c_str(), 0, -1));
+	if (zip_close(archive) < 0)
+		throw xlsx2tcpp::Exception{ "unable to write the “" + str_t{ file_name } + "” workbook" };
+	std::remove(sheet_name.c_str());
+}
+
+size_t
+get_file_size(char const* const file_name)
+{
+	return std::filesystem::file_size(file_name);
+}
+
+// The peak resident set size is reset to the current one by writing 5 in /proc/self/clear_refs
+// (Linux 4.0 and later), then read as VmHWM in /proc/self/status. Without them, it is the peak of
+// the process so far.
+void
+reset_peak_rss()
+{
+	std::ofstream{ "/proc/self/clear_refs" } << "5";
+}
+long
+get_peak_rss()
+{
+	std::ifstream in{ "/proc/self/status" };
+	for (str_t line; std::getline(in, line);)
+		if (line.compare(0, 6, "VmHWM:") == 0)
+			return std::stol(line.substr(6));
+	return xlsx2tcpp::get_peak_rss();
+}
+
+// One JSON object by line and by phase, with the peak resident set size during the phase:
+// {"phase":"build","rows":100000,"bytes":4523110,"seconds":0.52,"rows_per_s":192307,
+//  "mb_per_s":8.7,"peak_rss_kb":81234,"threads":8}
+class Report
+{
+public:
+	explicit Report(std::ostream& os)
+	  : os_(os)
+	{}
+	// The seconds taken by f(); the peak resident set size is reset before.
+	template<typename F>
+	static double time(F const& f)
+	{
+		reset_peak_rss();
+		auto const start{ std::chrono::steady_clock::now() };
+		f();
+		std::chrono::duration<double> const elapsed{ std::chrono::steady_clock::now() - start };
+		return std::max(elapsed.count(), 1e-9);
+	}
+	// The phase processed the rows of bytes bytes.
+	void print(char const* phase, size_t rows, size_t bytes, double seconds)
+	{
+		os_ << std::setprecision(6) << "{\"phase\":\"" << phase << "\",\"rows\":" << rows
+		    << ",\"bytes\":" << bytes << ",\"seconds\":" << seconds
+		    << ",\"rows_per_s\":" << rows / seconds << ",\"mb_per_s\":" << bytes / seconds / 1e6
+		    << ",\"peak_rss_kb\":" << get_peak_rss() << ",\"threads\":" << xlsx2tcpp::pool().size()
+		    << "}" << std::endl;
+	}
+	// One warm-up run, then runs (at least one) timed runs of f, each one after an untimed setup():
+	// {"bench":"replace_all","runs":50,"min_us":812,"p50_us":840,"p90_us":901,"p99_us":977,
+	//  "max_us":990}
+	template<typename F, typename Setup>
+	void measure(char const* name, size_t runs, F const& f, Setup const& setup)
+	{
+		setup(), f();
+		runs = std::max(size_t(1), runs);
+		std::vector<double> times;
+		for (size_t r{ 0 }; r < runs; ++r) {
+			setup();
+			times.push_back(time(f) * 1e6);
+		}
+		std::sort(begin(times), end(times));
+		auto const percentile{ [&](double p) { return times[size_t(p * (times.size() - 1) + 0.5)]; } };
+		os_ << std::setprecision(6) << "{\"bench\":\"" << name << "\",\"runs\":" << runs
+		    << ",\"min_us\":" << times.front() << ",\"p50_us\":" << percentile(0.5)
+		    << ",\"p90_us\":" << percentile(0.9) << ",\"p99_us\":" << percentile(0.99)
+		    << ",\"max_us\":" << times.back() << "}" << std::endl;
+	}
+	template<typename F>
+	void measure(char const* name, size_t runs, F const& f)
+	{
+		measure(name, runs, f, []() {});
+	}
+
+private:
+	std::ostream& os_;
+};
+
+} // namespace bench
+
+#endif // BENCH_HPP
@@ -26,6 +26,13 @@ typedef std::variant<str_t, int64_t, double> cell_t;
 // Type of the table returned by the read function.
 typedef std::vector<std::vector<cell_t>> table_t;
 
+// A workbook in memory, for instance received from the network or mapped from a file.
+struct Buffer
+{
+	void const* data;
+	size_t size;
+};
+
 // This function returns the value of the attribute “attr” of the tag “tag” in the “str” string from
 // “pos”. This function returns [value, pos, end, error].  “end” is true if the tag is not found.
 // “error” is true if the tag is found but if the closed quote is not found. “pos” is the new
@@ -316,6 +323,22 @@ struct Zip
 			throw Exception{ "unable to open the “" + str_t(file_name) +
 				               "” workbook (or the file is not a xlsx workbook)" };
 	}
+	// The buffer is not copied: it must live as long as the archive.
+	Zip(Buffer const& buffer)
+	{
+		zip_error_t zip_error;
+		zip_error_init(&zip_error);
+		auto const source_ptr{ zip_source_buffer_create(buffer.data, buffer.size, 0, &zip_error) };
+		archive_ptr_ = source_ptr ? zip_open_from_source(source_ptr, ZIP_RDONLY, &zip_error) : nullptr;
+		zip_error_fini(&zip_error);
+		if (!archive_ptr_) {
+			// The source is freed by the archive only if the archive is opened.
+			if (source_ptr)
+				zip_source_free(source_ptr);
+			throw Exception{ "unable to open the workbook in memory (or the buffer is not a xlsx "
+				               "workbook)" };
+		}
+	}
 	~Zip()
 	{
 		if (archive_ptr_)
@@ -327,11 +350,9 @@ struct Zip
 
 // Read a sheet and returns a table (vectors of vectors) of variants.
 std::pair<std::vector<std::vector<cell_t>>, str_t>
-get_table_sheetname(char const* const xlsx_file_name, char const* const sheet_name)
+get_table_sheetname(Zip const& zip, char const* const sheet_name)
 {
 
-	auto const zip{ Zip{ xlsx_file_name } };
-
 	// The archive tree is
 	//          _rels
 	//          xl
@@ -727,10 +748,26 @@ get_table_sheetname(char const* const xlsx_file_name, char const* const sheet_na
 	return { rvo, sheetname };
 }
 std::pair<std::vector<std::vector<cell_t>>, str_t>
+get_table_sheetname(char const* const xlsx_file_name, char const* const sheet_name)
+{
+	return get_table_sheetname(Zip{ xlsx_file_name }, sheet_name);
+}
+std::pair<std::vector<std::vector<cell_t>>, str_t>
 get_table_sheetname(char const* const xlsx_file_name)
 {
 	return get_table_sheetname(xlsx_file_name, "");
 }
+// The parsing starts straight from the memory, without a temporary file.
+std::pair<std::vector<std::vector<cell_t>>, str_t>
+get_table_sheetname(Buffer const& buffer, char const* const sheet_name = "")
+{
+	return get_table_sheetname(Zip{ buffer }, sheet_name);
+}
+std::vector<std::vector<cell_t>>
+read(Buffer const& buffer, char const* const sheet_name = "")
+{
+	return get_table_sheetname(buffer, sheet_name).first;
+}
 std::vector<std::vector<cell_t>>
 read(char const* const xlsx_file_name, char const* const sheet_name)
 {
@@ -744,10 +781,8 @@ read(char const* const xlsx_file_name)
 
 // Read a workbook and returns the worksheet name list.
 std::vector<str_t>
-get_worksheet_names(char const* const xlsx_file_name)
+get_worksheet_names(Zip const& zip)
 {
-
-	auto const zip{ Zip{ xlsx_file_name } };
 	auto const [wb_base, wb_name]{ get_wb_base_and_name(zip.archive_ptr_) };
 	auto const [ws_base, ws_names, shared]{ get_ws_and_shared(zip.archive_ptr_, wb_base, wb_name) };
 	auto const [nmspace, ids, active]{ get_ns_ids_and_active(zip.archive_ptr_, wb_base, wb_name) };
@@ -757,6 +792,16 @@ get_worksheet_names(char const* const xlsx_file_name)
 		rvo.push_back(p.first);
 	return rvo;
 }
+std::vector<str_t>
+get_worksheet_names(char const* const xlsx_file_name)
+{
+	return get_worksheet_names(Zip{ xlsx_file_name });
+}
+std::vector<str_t>
+get_worksheet_names(Buffer const& buffer)
+{
+	return get_worksheet_names(Zip{ buffer });
+}
 std::vector<std::vector<cell_t>>
 read(str_t const& xlsx_file_name, char const* const sheet_name)
 {
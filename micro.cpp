@@ -0,0 +1,158 @@
+#include "bench.hpp"
+
+// micro [runs=50]
+// Time the hot loops of the parser and of the helpers on generated inputs, with fixed seeds. The
+// report is written on the standard output, one JSON object by benchmark, with the percentiles of
+// the timings of the runs.
+
+namespace {
+
+struct Row
+{
+	int64_t id;
+	std::array<char, 8> name;
+	double x;
+};
+
+std::vector<Row>
+get_rows(size_t n, uint64_t seed)
+{
+	std::mt19937_64 gen{ seed };
+	std::vector<Row> rvo(n);
+	for (size_t i{ 0 }; i < n; ++i) {
+		rvo[i].id = int64_t(i);
+		rvo[i].name.fill('\0');
+		auto const name{ "name_" + std::to_string(gen() % 50) };
+		std::copy(cbegin(name), cend(name), begin(rvo[i].name));
+		rvo[i].x = (gen() % 10 == 0) ? std::numeric_limits<double>::quiet_NaN() : double(gen() % 1000);
+	}
+	// first and last presume that the table is sorted.
+	std::stable_sort(begin(rvo), end(rvo), [](Row const& a, Row const& b) {
+		return xlsx2tcpp::less(a.name, b.name);
+	});
+	return rvo;
+}
+
+// Wide strings with few distinct values, in random order, like the sort keys of build.
+struct Key_row
+{
+	int64_t id;
+	std::array<char, 64> key;
+};
+
+std::vector<Key_row>
+get_key_rows(size_t n, size_t distinct, uint64_t seed)
+{
+	std::mt19937_64 gen{ seed };
+	std::vector<Key_row> rvo(n);
+	for (size_t i{ 0 }; i < n; ++i) {
+		rvo[i].id = int64_t(i);
+		rvo[i].key.fill('\0');
+		auto const key{ "region_" + std::to_string(gen() % distinct) };
+		std::copy(cbegin(key), cend(key), begin(rvo[i].key));
+	}
+	return rvo;
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+
+	size_t runs{ 50 };
+	if (argc > 1) {
+		std::string const arg{ argv[1] };
+		if ((arg.rfind("runs=", 0) != 0) || (arg.size() == 5) ||
+		    (arg.find_first_not_of("0123456789", 5) != std::string::npos) ||
+		    ((runs = std::stoull(arg.substr(5))) == 0))
+			throw xlsx2tcpp::Exception{ "the argument “" + arg + "” is not “runs=N” with N > 0" };
+	}
+	xlsx2tcpp::set_progress(nullptr);
+	bench::Report report{ std::cout };
+
+	// The parser: a sheet of strings, a sheet of numbers, and the shared strings alone.
+	bench::Spec strings;
+	strings.rows = 20000, strings.shared = 4, strings.inline_strings = 2, strings.ints = 0,
+	strings.doubles = 0, strings.distinct = 20000;
+	bench::write_workbook("micro-strings.xlsx", strings);
+	bench::Spec numbers;
+	numbers.rows = 20000, numbers.shared = 0, numbers.inline_strings = 0, numbers.ints = 3,
+	numbers.doubles = 3;
+	bench::write_workbook("micro-numbers.xlsx", numbers);
+	report.measure("get_table_sheetname/strings", runs, []() {
+		fd_read_xlsx::get_table_sheetname("micro-strings.xlsx", "");
+	});
+	// The values are decoded by push_value.
+	report.measure("get_table_sheetname/numbers", runs, []() {
+		fd_read_xlsx::get_table_sheetname("micro-numbers.xlsx", "");
+	});
+	report.measure("get_shared_strings", runs, []() {
+		fd_read_xlsx::Zip const zip{ "micro-strings.xlsx" };
+		fd_read_xlsx::get_shared_strings(zip.archive_ptr_, "xl/sharedStrings.xml", "");
+	});
+
+	// replace_all on 1 MB of text with some entities.
+	std::string text;
+	for (size_t i{ 0 }; text.size() < (1 << 20); ++i)
+		text += (i % 8 == 0) ? "a &lt; b &gt; c " : "plain text, ";
+	std::string copy;
+	report.measure(
+	  "replace_all",
+	  runs,
+	  [&]() {
+		  fd_read_xlsx::replace_all(copy, "&lt;", '<');
+		  fd_read_xlsx::replace_all(copy, "&gt;", '>');
+	  },
+	  [&]() { copy = text; });
+
+	// The helpers on a table of 1 million rows.
+	auto const table{ get_rows(1000000, 1) };
+	std::mt19937_64 gen{ 2 };
+	std::vector<int64_t> keys(10000);
+	for (auto& key : keys)
+		key = int64_t(gen() % table.size());
+	xlsx2tcpp::Index<Row, int64_t> const index{ table, &Row::id };
+	report.measure("index/10000 lookups", runs, [&]() {
+		size_t sum{ 0 };
+		for (auto const key : keys)
+			sum += index.at(key);
+		if (sum == 0)
+			std::abort();
+	});
+	report.measure("freq", runs, [&]() { xlsx2tcpp::freq(table, &Row::name, "name"); });
+	report.measure("first/last", runs, [&]() {
+		size_t n{ 0 };
+		for (auto const& row : table)
+			n += xlsx2tcpp::first(table, row.name) + xlsx2tcpp::last(table, row.name);
+		if (n == 0)
+			std::abort();
+	});
+	report.measure("not_missing", runs, [&]() {
+		if (xlsx2tcpp::not_missing(table, &Row::x) == 0)
+			std::abort();
+	});
+
+	// The sort of the strings, by radix and by comparison, on 1 million rows with 1, 3 and 1000
+	// distinct values.
+	for (size_t const distinct : { 1, 3, 1000 }) {
+		auto const keys{ get_key_rows(1000000, distinct, 3) };
+		auto const suffix{ "/" + std::to_string(distinct) + " distinct" };
+		auto const sort_runs{ std::max(size_t(1), runs / 10) };
+		report.measure(("radix_permutation" + suffix).c_str(), sort_runs, [&]() {
+			xlsx2tcpp::radix_permutation(keys, &Key_row::key);
+		});
+		report.measure(("stable_sort" + suffix).c_str(), sort_runs, [&]() {
+			std::vector<size_t> ids(keys.size());
+			std::iota(begin(ids), end(ids), 0);
+			std::stable_sort(begin(ids), end(ids), [&](size_t i, size_t j) {
+				return xlsx2tcpp::less(keys[i].key, keys[j].key);
+			});
+		});
+	}
+
+	std::remove("micro-strings.xlsx");
+	std::remove("micro-numbers.xlsx");
+
+	return 0;
+}
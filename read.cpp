@@ -10,7 +10,8 @@ main()
 	for (auto const& row : table)
 		std::cout << row.a << '\n';
 
-	std::cout << xlsx2tcpp::index(table, &test_sheet1::a, 2l) << '\n';
+	xlsx2tcpp::Index const index{ table, &test_sheet1::a };
+	std::cout << index.at(2) << '\n';
 
 	return 0;
 }
@@ -2,16 +2,47 @@
 #define XLSX2TCPP_HPP
 
 #include <fd-read-xlsx-header-only.hpp>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <sstream>
 #include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 
 #include <cassert>
+#include <cerrno>
 #include <cmath>
 #include <cstdio>
 #include <cstring>
+#include <fcntl.h>
+#include <glob.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <zlib.h>
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 // We need to define
 // 1) xlsx2tcpp::missing(std::array<char, N>);
@@ -27,6 +58,52 @@ missing(std::array<char, N> const& a)
 {
 	return a[0] == '\0' ;
 }
+bool
+missing(int64_t i)
+{
+	return i == std::numeric_limits<int64_t>::max();
+}
+bool
+missing(double x)
+{
+	return std::isnan(x);
+}
+template<size_t N>
+void
+set_missing(std::array<char, N>& a)
+{
+	a.fill('\0');
+}
+void
+set_missing(int64_t& i)
+{
+	i = std::numeric_limits<int64_t>::max();
+}
+void
+set_missing(double& x)
+{
+	x = std::numeric_limits<double>::quiet_NaN();
+}
+// Strict weak ordering of the values of the data members: the missing values are the greatest ones
+// and the strings are compared as unsigned chars.
+bool
+less(int64_t i, int64_t j)
+{
+	return i < j;
+}
+bool
+less(double x, double y)
+{
+	return (x < y) || (!std::isnan(x) && std::isnan(y));
+}
+template<size_t N>
+bool
+less(std::array<char, N> const& a, std::array<char, N> const& b)
+{
+	if (missing(a) || missing(b))
+		return !missing(a) && missing(b);
+	return std::memcmp(a.data(), b.data(), N) < 0;
+}
 } // namespace xlsx2tcpp
 
 // This template is put in the std namespace (bad pratice ?).
@@ -65,21 +142,42 @@ private:
 	str_t const msg_;
 };
 
+// FNV-1a hash, used for the layout of a struct and for the contents of the chunks.
+uint64_t
+hash(void const* const ptr, size_t size, uint64_t h = 14695981039346656037ull)
+{
+	auto const bytes{ static_cast<unsigned char const*>(ptr) };
+	for (size_t i{ 0 }; i < size; ++i)
+		h = (h ^ bytes[i]) * 1099511628211ull;
+	return h;
+}
+
+// The extension is compared in lower case.
+bool
+has_extension(str_t const& name, str_t const& extension)
+{
+	return (name.size() > extension.size()) &&
+	       std::equal(crbegin(extension), crend(extension), crbegin(name), [](char c, char d) {
+		       return c == std::tolower(static_cast<unsigned char>(d));
+	       });
+}
+// The base file name, without the extension if it is an Excel, a CSV or a TSV one.
+str_t
+get_base_name(char const* const file_name)
+{
+	str_t const name{ file_name };
+	auto const last{ name.rfind('/') };
+	auto const begin{ ((last == str_t::npos) && (last != name.size() - 1)) ? 0 : last + 1 };
+	for (str_t const end : { ".xlsx", ".csv", ".tsv" })
+		if (has_extension(name, end))
+			return str_t(cbegin(name) + begin, cend(name) - end.size());
+	return (begin == 0) ? name : str_t(cbegin(name) + begin, cend(name));
+}
+
 std::pair<str_t, str_t>
 get_names(char const* const xlsx_file_name, str_t const& sheetname)
 {
-	// Get the base file name et chop the extension if it is an Excel one.
-	str_t const xlsx_file_name_base{ [&]() {
-		str_t const name{ xlsx_file_name };
-		auto const last{ name.rfind('/') };
-		auto const begin{ ((last == str_t::npos) && (last != name.size() - 1)) ? 0 : last + 1 };
-		str_t const end{ ".xlsx" };
-		str_t const END{ ".XLSX" };
-		if ((name.size() > end.size()) && (std::equal(crbegin(end), crend(end), crbegin(name)) ||
-		                                   std::equal(crbegin(END), crend(END), crbegin(name))))
-			return str_t(cbegin(name) + begin, cend(name) - end.size());
-		return (begin == 0) ? name : str_t(cbegin(name) + begin, cend(name));
-	}() };
+	auto const xlsx_file_name_base{ get_base_name(xlsx_file_name) };
 
 	str_t file_name, struct_name;
 	// If same names, do not duplicate.
@@ -99,13 +197,362 @@ get_names(char const* const xlsx_file_name, str_t const& sheetname)
 	}
 	return { file_name, struct_name };
 }
+
+// Instrumentation of init, build and read
+//   set_progress(nullptr);          // no progress messages (they are written on std::cout)
+//   set_stats([](Stats const& stats) { std::clog << stats.to_json() << '\n'; });
+// After each call of init, build or read, the callback, if any, is given the statistics of the
+// call: the time of its phases, the numbers of cells parsed and of rows converted, the bytes of the
+// rows and of the chunks, and the time spent by each thread zipping or unzipping the chunks.
+struct Stats
+{
+	str_t operation;
+	// The workbook or the directory of the chunks.
+	str_t name;
+	double seconds{ 0 };
+	std::vector<std::pair<str_t, double>> phases;
+	size_t cells{ 0 };
+	size_t rows{ 0 };
+	size_t row_bytes{ 0 };
+	size_t chunk_bytes{ 0 };
+	std::vector<double> thread_seconds;
+	// If the memory is accounted: by phase, the most bytes held by the main structures during the
+	// phase, and the peak resident set size of the process at its end.
+	struct Memory
+	{
+		str_t phase;
+		std::vector<std::pair<str_t, size_t>> bytes;
+		long peak_rss_kb;
+	};
+	std::vector<Memory> memory;
+
+	str_t to_json() const
+	{
+		auto const quote{ [](str_t const& str) {
+			str_t rvo{ '"' };
+			for (auto const c : str)
+				if ((c == '"') || (c == '\\'))
+					rvo += '\\', rvo += c;
+				else if (static_cast<unsigned char>(c) < 0x20)
+					rvo += ' ';
+				else
+					rvo += c;
+			return rvo + '"';
+		} };
+		std::ostringstream out;
+		out << "{\"operation\":" << quote(operation) << ",\"name\":" << quote(name)
+		    << ",\"seconds\":" << seconds << ",\"phases\":{";
+		for (size_t k{ 0 }; k < phases.size(); ++k)
+			out << (k ? "," : "") << quote(phases[k].first) << ':' << phases[k].second;
+		out << "},\"cells\":" << cells << ",\"rows\":" << rows << ",\"row_bytes\":" << row_bytes
+		    << ",\"chunk_bytes\":" << chunk_bytes << ",\"thread_seconds\":[";
+		for (size_t k{ 0 }; k < thread_seconds.size(); ++k)
+			out << (k ? "," : "") << thread_seconds[k];
+		out << "]";
+		if (!memory.empty()) {
+			out << ",\"memory\":[";
+			for (size_t k{ 0 }; k < memory.size(); ++k) {
+				out << (k ? "," : "") << "{\"phase\":" << quote(memory[k].phase)
+				    << ",\"peak_rss_kb\":" << memory[k].peak_rss_kb << ",\"bytes\":{";
+				for (size_t l{ 0 }; l < memory[k].bytes.size(); ++l)
+					out << (l ? "," : "") << quote(memory[k].bytes[l].first) << ':'
+					    << memory[k].bytes[l].second;
+				out << "}}";
+			}
+			out << "]";
+		}
+		out << "}";
+		return out.str();
+	}
+};
+
+std::ostream*&
+get_progress_ptr()
+{
+	static std::ostream* ptr{ &std::cout };
+	return ptr;
+}
+// The progress messages are written on os; none if os is null.
+void
+set_progress(std::ostream* os)
+{
+	get_progress_ptr() = os;
+}
+// Without progress, the messages go to a stream without buffer, which sets its state and writes
+// nothing: one by thread, since build_dataset builds from several threads.
+std::ostream&
+progress()
+{
+	static thread_local std::ostream null{ nullptr };
+	auto const ptr{ get_progress_ptr() };
+	return ptr ? *ptr : null;
+}
+
+std::mutex&
+get_stats_mutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+std::function<void(Stats const&)>&
+get_stats_callback()
+{
+	static std::function<void(Stats const&)> callback;
+	return callback;
+}
+// The callback is called by the thread which called init, build or read; an empty callback stops
+// the statistics.
+void
+set_stats(std::function<void(Stats const&)> callback)
+{
+	std::lock_guard<std::mutex> lock{ get_stats_mutex() };
+	get_stats_callback() = std::move(callback);
+}
+std::atomic<bool>&
+get_memory_accounting()
+{
+	static std::atomic<bool> on{ false };
+	return on;
+}
+// Add the memory by phase to the statistics. The bytes of the table of the cells are counted by a
+// walk of the table, so the accounting is off by default.
+void
+set_memory_accounting(bool on)
+{
+	get_memory_accounting() = on;
+}
+// The peak resident set size of the process, in KiB.
+long
+get_peak_rss()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+namespace internals {
+// The statistics of a call, recorded by the threads of the pool.
+class Recorder
+{
+public:
+	Recorder(char const* operation, str_t const& name)
+	  : start_(std::chrono::steady_clock::now())
+	  , last_(start_)
+	{
+		stats_.operation = operation, stats_.name = name;
+	}
+	// End the current phase.
+	void end_phase(char const* phase)
+	{
+		auto const now{ std::chrono::steady_clock::now() };
+		stats_.phases.emplace_back(phase, std::chrono::duration<double>(now - last_).count());
+		last_ = now;
+		if (accounting()) {
+			Stats::Memory memory{ phase, {}, get_peak_rss() };
+			for (auto const& [structure, bytes] : most_)
+				if (bytes > 0)
+					memory.bytes.emplace_back(structure, bytes);
+			stats_.memory.push_back(memory);
+			most_ = held_;
+		}
+	}
+	bool accounting() const { return accounting_; }
+	// The structure holds bytes bytes from now on.
+	void hold(char const* structure, size_t bytes)
+	{
+		held_[structure] = bytes;
+		most_[structure] = std::max(most_[structure], bytes);
+	}
+	void add_cells(size_t n) { cells_ += n; }
+	void add_rows(size_t n, size_t row_bytes) { rows_ += n, row_bytes_ += n * row_bytes; }
+	// Zip or unzip a chunk of chunk_bytes bytes by f(), on the current thread.
+	template<typename F>
+	void time_chunk(F const& f, str_t const& chunk_name)
+	{
+		auto const start{ std::chrono::steady_clock::now() };
+		f();
+		std::chrono::duration<double> const elapsed{ std::chrono::steady_clock::now() - start };
+		std::error_code error;
+		auto const size{ std::filesystem::file_size(chunk_name, error) };
+		chunk_bytes_ += error ? 0 : size;
+		std::lock_guard<std::mutex> lock{ mutex_ };
+		thread_seconds_[std::this_thread::get_id()] += elapsed.count();
+	}
+	// Give the statistics to the callback, if any.
+	void finish()
+	{
+		std::function<void(Stats const&)> callback;
+		{
+			std::lock_guard<std::mutex> lock{ get_stats_mutex() };
+			callback = get_stats_callback();
+		}
+		if (!callback)
+			return;
+		stats_.seconds = std::chrono::duration<double>(last_ - start_).count();
+		stats_.cells = cells_, stats_.rows = rows_;
+		stats_.row_bytes = row_bytes_, stats_.chunk_bytes = chunk_bytes_;
+		for (auto const& [id, seconds] : thread_seconds_)
+			stats_.thread_seconds.push_back(seconds);
+		callback(stats_);
+	}
+
+private:
+	std::chrono::steady_clock::time_point const start_;
+	std::chrono::steady_clock::time_point last_;
+	Stats stats_;
+	bool const accounting_{ get_memory_accounting() };
+	std::map<str_t, size_t> held_;
+	std::map<str_t, size_t> most_;
+	std::atomic<size_t> cells_{ 0 };
+	std::atomic<size_t> rows_{ 0 };
+	std::atomic<size_t> row_bytes_{ 0 };
+	std::atomic<size_t> chunk_bytes_{ 0 };
+	std::mutex mutex_;
+	std::map<std::thread::id, double> thread_seconds_;
+};
+size_t
+get_nr_cells(fd_read_xlsx::table_t const& table)
+{
+	size_t rvo{ 0 };
+	for (auto const& row : table)
+		rvo += row.size();
+	return rvo;
+}
+// The table and the name of the sheet of a workbook, or of a CSV or TSV file (see read_csv). If the
+// buffer is not null, it holds the contents of the file, whose name gives only the format.
+std::pair<fd_read_xlsx::table_t, str_t>
+get_table_sheetname(char const* const file_name,
+                    char const* const sheet_name,
+                    fd_read_xlsx::Buffer const* const buffer = nullptr);
+} // namespace internals
+
+// The columns of a sheet are stored by init in the binary “file_name.cols” file, next to the
+// workbook, with the types and the widths of the data members: build fills the rows from them
+// instead of parsing the workbook again. The file is a header, the widths of the columns, then the
+// columns, each one padded to 8 bytes. It is used only if the workbook (its canonical path, its
+// size and the time of its last modification), the sheet and the layout of the struct are the
+// same.
+struct Columns_header
+{
+	char magic[8];
+	uint64_t layout;
+	// The hash of the canonical path, the size and the time of the last modification of the workbook.
+	uint64_t source_hash;
+	uint64_t source_size;
+	int64_t source_time;
+	// The hashes of the requested sheet name and of the name of the sheet read.
+	uint64_t sheet_hash;
+	uint64_t sheetname_hash;
+	uint64_t n;
+	uint64_t nr_cols;
+};
+
+constexpr char columns_magic[8]{ 'x', 'l', 's', 'x', '2', 't', 'c', 'd' };
+
+std::tuple<uint64_t, uint64_t, int64_t>
+get_source_hash_size_time(char const* const xlsx_file_name)
+{
+	auto const path{ std::filesystem::canonical(xlsx_file_name).string() };
+	return { hash(path.data(), path.size()),
+		       std::filesystem::file_size(xlsx_file_name),
+		       std::filesystem::last_write_time(xlsx_file_name).time_since_epoch().count() };
+}
+// The columns of the workbook are next to it.
+str_t
+get_columns_name(char const* const xlsx_file_name, str_t const& file_name)
+{
+	return (std::filesystem::path{ xlsx_file_name }.parent_path() / (file_name + ".cols")).string();
+}
+uint64_t
+get_sheet_hash(str_t const& sheet_name)
+{
+	return hash(sheet_name.data(), sheet_name.size());
+}
+size_t
+get_padded(size_t bytes)
+{
+	return (bytes + 7) / 8 * 8;
+}
+
 namespace internals {
+// Write the columns of the table: the width of a string column is the size of its array, the
+// missing values are the ones of the data members. The columns are a cache: false if they cannot
+// be written, as in a read-only directory, and build then reads the workbook.
+bool
+write_columns(str_t const& file_name,
+              char const* const xlsx_file_name,
+              char const* const sheet_name,
+              str_t const& sheetname,
+              uint64_t layout,
+              fd_read_xlsx::table_t const& table,
+              std::vector<bool> const& is_str,
+              std::vector<bool> const& is_int,
+              std::vector<uint64_t> const& widths)
+{
+	auto const columns_name{ get_columns_name(xlsx_file_name, file_name) };
+	auto const name{ columns_name + ".tmp" };
+	std::ofstream out{ name, std::ios::binary };
+	if (!out.is_open())
+		return false;
+	auto const [source_hash, source_size, source_time]{ get_source_hash_size_time(xlsx_file_name) };
+	Columns_header header{ {},
+		                     layout,
+		                     source_hash,
+		                     source_size,
+		                     source_time,
+		                     get_sheet_hash(sheet_name),
+		                     get_sheet_hash(sheetname),
+		                     table.size() - 1,
+		                     widths.size() };
+	std::memcpy(header.magic, columns_magic, sizeof(header.magic));
+	out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+	out.write(reinterpret_cast<char const*>(widths.data()), widths.size() * sizeof(uint64_t));
+	std::vector<char> column;
+	for (size_t j{ 0 }; j < widths.size(); ++j) {
+		column.assign(get_padded((table.size() - 1) * widths[j]), '\0');
+		for (size_t i{ 1 }; i < table.size(); ++i) {
+			auto const ptr{ column.data() + (i - 1) * widths[j] };
+			bool const empty{ (j >= table[i].size()) || fd_read_xlsx::empty(table[i][j]) };
+			if (is_str[j]) {
+				if (!empty)
+					std::get<str_t>(table[i][j]).copy(ptr, widths[j]);
+			} else if (is_int[j]) {
+				auto const value{ empty ? std::numeric_limits<int64_t>::max()
+					                      : fd_read_xlsx::get_int(table[i][j]) };
+				std::memcpy(ptr, &value, sizeof(value));
+			} else {
+				auto const value{ empty ? std::numeric_limits<double>::quiet_NaN()
+					                      : fd_read_xlsx::get_num(table[i][j]) };
+				std::memcpy(ptr, &value, sizeof(value));
+			}
+		}
+		out.write(column.data(), column.size());
+	}
+	out.close();
+	std::error_code ec;
+	if (out)
+		std::filesystem::rename(name, columns_name, ec);
+	if (!out || ec) {
+		std::filesystem::remove(name, ec);
+		return false;
+	}
+	return true;
+}
+
+// If the buffer is not null, the workbook is read from it and its columns are not written: they
+// could not be checked against the workbook at build time.
 void
-init(char const* const xlsx_file_name, char const* const sheet_name, bool lower)
+init(char const* const xlsx_file_name,
+     char const* const sheet_name,
+     bool lower,
+     fd_read_xlsx::Buffer const* const buffer = nullptr)
 {
-	std::cout << "Reading “" << xlsx_file_name << "”...\n";
-	auto const [table, sheetname]{ fd_read_xlsx::get_table_sheetname(xlsx_file_name, sheet_name) };
-	std::cout << "Analysing “" << sheetname << "” sheet of “" << xlsx_file_name << "”...\n";
+	Recorder recorder{ "init", xlsx_file_name };
+	progress() << "Reading “" << xlsx_file_name << "”...\n";
+	auto const [table, sheetname]{ get_table_sheetname(xlsx_file_name, sheet_name, buffer) };
+	recorder.end_phase("read_xlsx");
+	recorder.add_cells(get_nr_cells(table));
+	progress() << "Analysing “" << sheetname << "” sheet of “" << xlsx_file_name << "”...\n";
 	if (table.size() < 2)
 		throw Exception("the number of rows in the worksheet is less than 2");
 	for (size_t j{ 0 }; j < table[0].size(); ++j) {
@@ -127,7 +574,7 @@ init(char const* const xlsx_file_name, char const* const sheet_name, bool lower)
 	std::vector<size_t> str_szs(nr_cols);
 	std::vector<bool> is_int(nr_cols, false);
 	for (size_t j{ 0 }; j < nr_cols; ++j) {
-		std::cout << "Analysing “" << fd_read_xlsx::get_string(table[0][j]) << "” row...\n";
+		progress() << "Analysing “" << fd_read_xlsx::get_string(table[0][j]) << "” row...\n";
 		// Test for string.
 		bool flag{ true };
 		for (size_t i{ 1 }; i < table.size(); ++i)
@@ -171,20 +618,16 @@ init(char const* const xlsx_file_name, char const* const sheet_name, bool lower)
 			}
 		}
 	}
+	recorder.end_phase("analyse");
 	auto const [file_name, struct_name]{ get_names(xlsx_file_name, sheetname) };
 
-	std::ofstream out{ file_name + ".hpp" };
-	if (!out.is_open())
-		throw Exception{ "unable to open for output “" + file_name + ".hpp”" };
+	// The header is generated in memory and written only if it changes: the number of rows is not
+	// in the header, so the programs which include it are not recompiled when rows are appended.
+	std::ostringstream out;
 	out << "#include <xlsx2tcpp.hpp>\n";
-	out << "#include <array>\n\n";
+	out << "#include <array>\n";
+	out << "#include <tuple>\n\n";
 	out << "struct " << struct_name << "{\n";
-	// Declare and initialize a static data member with some usefull information.
-	out << "\tstruct { size_t n; char const *file_name; char const *struct_name; size_t nr_threads; "
-	       "}\n";
-	out << "\t\tstatic constexpr _info_ {\n";
-	out << "\t\t\t" << (table.size() - 1) << ", \"" << file_name << "\", \"" << struct_name << "\", "
-	    << std::thread::hardware_concurrency() << " };\n";
 	// Convert the name of the variables to lowercase.
 	auto const to_lower{ [&](str_t const& str) {
 		if (!lower)
@@ -195,17 +638,31 @@ init(char const* const xlsx_file_name, char const* const sheet_name, bool lower)
 		return rvo;
 	} };
 	// The data members.
+	str_t members;
 	for (size_t j{ 0 }; j < nr_cols; ++j) {
 		// If the variable is always empty, give a size of 1 : an array of size 0 is valid but
 		// is implemented with a C array of size 1. No gains but undefined behavior...
 		if (is_str[j])
-			out << "\tstd::array<char, " << std::max(str_szs[j], size_t(1)) << "> "
-			    << to_lower(fd_read_xlsx::get_string(table[0][j])) << ";\n";
+			members += "\tstd::array<char, " + std::to_string(std::max(str_szs[j], size_t(1))) + "> " +
+			           to_lower(fd_read_xlsx::get_string(table[0][j])) + ";\n";
 		else if (is_int[j])
-			out << "\tint64_t " << to_lower(fd_read_xlsx::get_string(table[0][j])) << ";\n";
+			members += "\tint64_t " + to_lower(fd_read_xlsx::get_string(table[0][j])) + ";\n";
 		else
-			out << "\tdouble " << to_lower(fd_read_xlsx::get_string(table[0][j])) << ";\n";
+			members += "\tdouble " + to_lower(fd_read_xlsx::get_string(table[0][j])) + ";\n";
 	}
+	// Declare and initialize a static data member with some usefull information. The layout is a
+	// hash of the data members: the chunks built with another layout are rejected at read time.
+	out << "\tstruct { char const *file_name; char const *struct_name; uint64_t layout; }\n";
+	out << "\t\tstatic constexpr _info_ {\n";
+	auto const layout{ hash(members.data(), members.size()) };
+	out << "\t\t\t\"" << file_name << "\", \"" << struct_name << "\", " << layout << "ull };\n";
+	out << members;
+	// The pointers to the data members, in the order of the columns.
+	out << "\tstatic constexpr auto _members_() { return std::make_tuple(";
+	for (size_t j{ 0 }; j < nr_cols; ++j)
+		out << (j ? ", &" : "&") << struct_name
+		    << "::" << to_lower(fd_read_xlsx::get_string(table[0][j]));
+	out << "); }\n";
 	// The constructors.
 	out << '\t' << struct_name << "() {}\n";
 	out << '\t' << struct_name << "(std::vector<fd_read_xlsx::cell_t> const & _v_)\n";
@@ -255,6 +712,31 @@ init(char const* const xlsx_file_name, char const* const sheet_name, bool lower)
 	out << "\t\t}\n";
 
 	out << "};\n";
+
+	auto const contents{ [&]() {
+		std::ifstream in{ file_name + ".hpp" };
+		return str_t{ std::istreambuf_iterator<char>{ in }, std::istreambuf_iterator<char>{} };
+	}() };
+	if (contents != out.str()) {
+		std::ofstream file{ file_name + ".hpp" };
+		if (!file.is_open())
+			throw Exception{ "unable to open for output “" + file_name + ".hpp”" };
+		file << out.str();
+	}
+	recorder.end_phase("header");
+	if (!buffer) {
+		progress() << "Writing the columns of “" << file_name << "”...\n";
+		std::vector<uint64_t> widths(nr_cols, sizeof(int64_t));
+		for (size_t j{ 0 }; j < nr_cols; ++j)
+			if (is_str[j])
+				widths[j] = std::max(str_szs[j], size_t(1));
+		if (!write_columns(
+		      file_name, xlsx_file_name, sheet_name, sheetname, layout, table, is_str, is_int, widths))
+			progress() << "The columns of “" << file_name << "” are not written: build will read “"
+			           << xlsx_file_name << "”.\n";
+		recorder.end_phase("columns");
+	}
+	recorder.finish();
 }
 }
 void
@@ -267,215 +749,3503 @@ lower_init(char const* const xlsx_file_name, char const* const sheet_name = "")
 {
 	internals::init(xlsx_file_name, sheet_name, true);
 }
-
-template<typename T>
+// A workbook, or a CSV or TSV file, held in memory: the name gives the format and the names of the
+// struct and of the header, as the name of a file would.
+//   init(fd_read_xlsx::Buffer{ payload.data(), payload.size() }, "sales.xlsx");
 void
-task_write(str_t const& file_name, std::vector<T> const& tcpp, size_t start, size_t end)
+init(fd_read_xlsx::Buffer const& buffer, char const* const name, char const* const sheet_name = "")
 {
-	if (start == end)
-		return;
-	// compression level 9.
-	auto out{ gzopen(file_name.c_str(), "wb9") };
-	if (out == NULL)
-		throw Exception{ "unable to open for output the “" + file_name + "” file" };
-	size_t const n =
-	  gzwrite(out, reinterpret_cast<char const*>(&tcpp[start]), (end - start) * sizeof(T));
-	auto const ret{ gzclose(out) };
-	if (n != (end - start) * sizeof(T))
-		throw Exception{ "unable to append the zipped stream into the “" + file_name + "” file" };
-	if (ret != Z_OK)
-		throw Exception{ "unable to close the “" + file_name + "” file" };
+	internals::init(name, sheet_name, false, &buffer);
 }
-template<typename T>
 void
-build(char const* const xlsx_file_name, char const* const sheet_name = "")
+lower_init(fd_read_xlsx::Buffer const& buffer,
+           char const* const name,
+           char const* const sheet_name = "")
 {
-	std::cout << "Reading “" << xlsx_file_name << "”...\n";
-	auto const table{ fd_read_xlsx::read(xlsx_file_name, sheet_name) };
-	if (T::_info_.n != (table.size() - 1))
-		throw Exception("T::_info_.n (" + std::to_string(T::_info_.n) + ") != (table.size()-1) (" +
-		                std::to_string(table.size() - 1) + ')');
-	std::vector<T> tcpp;
-	tcpp.reserve(table.size() - 1);
-	std::cout << "Copying “" << T::_info_.file_name << "”...\n";
-	for (size_t i{ 1 }; i < table.size(); ++i)
-		tcpp.push_back(T{ table[i] });
-
-	std::cout << "Zipping “" << T::_info_.file_name << "”...\n";
-	// Be careful to create the directory.
-	if (!std::filesystem::exists(T::_info_.file_name))
-		if (!std::filesystem::create_directory(T::_info_.file_name))
-			throw Exception{ "unable to create “" + str_t{ T::_info_.file_name } + "” directory" };
-
-	auto const nr_threads{ T::_info_.nr_threads };
-	std::vector<std::thread> threads;
-	threads.reserve(nr_threads);
-	auto const step{ tcpp.size() / nr_threads + 1 };
-	size_t start{ 0 };
-	for (size_t i = 0; i < nr_threads; ++i) {
-		auto const name{ str_t{ T::_info_.file_name } + '/' + std::to_string(i) + ".gz" };
-		auto const end{ std::min(start + step, tcpp.size()) };
-		threads.emplace_back(task_write<T>, name, tcpp, start, end);
-		start = end;
-	}
-	for (auto& thread : threads)
-		thread.join();
+	internals::init(name, sheet_name, true, &buffer);
 }
+
+// Number of rows in a chunk: a chunk is the unit of compression, of parallelism and of the zone
+// maps.
+constexpr size_t chunk_rows{ 1 << 16 };
+
 template<typename T>
+constexpr size_t nr_members{ std::tuple_size_v<decltype(T::_members_())> };
+
+// Call f(m_ptr, j) for each data member of T, where j is the column of the data member.
+template<typename T, typename F>
 void
-task_read(str_t const& file_name, std::vector<T>& rvo, size_t start, size_t end)
+for_each_member(F&& f)
 {
-	if (start == end)
-		return;
-	auto in{ gzopen(file_name.c_str(), "rb") };
-	if (in == NULL)
-		throw Exception{ "unable to open for input the “" + file_name + "” file" };
-	size_t const n = gzread(in, reinterpret_cast<char*>(&rvo[start]), (end - start) * sizeof(T));
-	auto const ret{ gzclose(in) };
-	if (n != (end - start) * sizeof(T))
-		throw Exception{ "unable to read the zipped stream from the “" + file_name + "” file" };
-	if (ret != Z_OK)
-		throw Exception{ "unable to close the “" + file_name + "” file" };
+	std::apply(
+	  [&](auto... m_ptrs) {
+		  size_t j{ 0 };
+		  (f(m_ptrs, j++), ...);
+	  },
+	  T::_members_());
 }
+
+// A chunk is stored in the “id-hash.gz” file, named after its contents: a rebuild writes the
+// changed chunks in new files, so the chunks of the previous manifest stay valid until the new
+// manifest replaces it. Its zone map is made of the rows of the min and max values of each data
+// member, and of the number of missing values of each data member. If all the values of a data
+// member are missing, its min and max are missing. The hash of the contents of the chunk is used to
+// rewrite only the changed chunks.
 template<typename T>
-std::vector<T>
-read(str_t const& dir_name = "")
+struct Chunk
 {
-	std::vector<T> rvo{ T::_info_.n };
-	auto const nr_threads{ T::_info_.nr_threads };
-	std::vector<std::thread> threads;
-	threads.reserve(nr_threads);
-	auto const step{ rvo.size() / nr_threads + 1 };
-	size_t start{ 0 };
-	for (size_t i = 0; i < nr_threads; ++i) {
-		auto const name{ (dir_name.empty() ? str_t{} : (dir_name + '/')) +
-			               str_t{ T::_info_.file_name } + '/' + std::to_string(i) + ".gz" };
-		auto const end{ std::min(start + step, rvo.size()) };
-		threads.emplace_back(task_read<T>, name, std::ref(rvo), start, end);
-		start = end;
-	}
-	for (auto& thread : threads)
-		thread.join();
+	size_t id;
+	size_t start;
+	size_t n;
+	uint64_t hash;
+	T min;
+	T max;
+	std::array<size_t, nr_members<T>> nulls;
+};
+
+template<typename T>
+Chunk<T>
+get_chunk(std::vector<T> const& tcpp, size_t id, size_t start, size_t end)
+{
+	Chunk<T> rvo;
+	rvo.id = id, rvo.start = start, rvo.n = end - start, rvo.hash = hash(nullptr, 0);
+	// The data members are hashed one by one: the padding bytes of the rows are indeterminate.
+	for_each_member<T>([&](auto m_ptr, size_t j) {
+		auto& min{ rvo.min.*m_ptr };
+		auto& max{ rvo.max.*m_ptr };
+		set_missing(min), set_missing(max);
+		rvo.nulls[j] = 0;
+		for (size_t i{ start }; i < end; ++i) {
+			auto const& u{ tcpp[i].*m_ptr };
+			rvo.hash = hash(&u, sizeof(u), rvo.hash);
+			if (missing(u))
+				++rvo.nulls[j];
+			else if (missing(min))
+				min = max = u;
+			else if (less(u, min))
+				min = u;
+			else if (less(max, u))
+				max = u;
+		}
+	});
 	return rvo;
 }
-// Usage
-//   for ( auto const & row : table ) {
-//       if ( first(table, row.a) ) {
-//           ...
-//
-// It is presumed that table is sorted by the values of a. The function returns
-// true if it is the first row or if the value of a from the previous row is
-// not equal to the value of current row.
-template<typename T, typename U>
-bool
-first(std::vector<T> const& table, U const& u)
+
+// The manifest of the chunks is stored in the binary “manifest” file, within the directory of the
+// chunks: a header, the columns of the sort keys, then the chunks. If the keys are not empty, the
+// rows are sorted by the keys.
+template<typename T>
+struct Manifest
 {
-	auto const address_table{ reinterpret_cast<char const*>(&table[0]) };
-	auto const address_u{ reinterpret_cast<char const*>(&u) };
-	assert(address_table <= address_u);
-	// Narrowing initializations for the compiler...
-	size_t i = (address_u - address_table) / sizeof(T);
-	size_t offset = address_u - (address_table + i * sizeof(T));
-	if (i == 0)
-		return true;
-	return std::memcmp(address_table + (i - 1) * sizeof(T) + offset,
-	                   address_table + i * sizeof(T) + offset,
-	                   sizeof(U)) != 0;
-}
-template<typename T, typename U>
-bool
-last(std::vector<T> const& table, U const& u)
+	size_t n;
+	std::vector<uint64_t> keys;
+	std::vector<Chunk<T>> chunks;
+};
+
+struct Manifest_header
 {
-	auto const address_table{ reinterpret_cast<char const*>(&table[0]) };
-	auto const address_u{ reinterpret_cast<char const*>(&u) };
-	assert(address_table <= address_u);
-	auto const i{ size_t(address_u - address_table) / sizeof(T) };
-	auto const offset{ size_t(address_u - (address_table + i * sizeof(T))) };
-	if (i >= table.size())
-		return true;
-	return std::memcmp(address_table + i * sizeof(T) + offset,
-	                   address_table + (i + 1) * sizeof(T) + offset,
-	                   sizeof(U)) != 0;
-}
-bool
-missing(int64_t i)
+	char magic[8];
+	uint64_t layout;
+	uint64_t size;
+	uint64_t n;
+	uint64_t nr_keys;
+	uint64_t nr_chunks;
+};
+
+constexpr char manifest_magic[8]{ 'x', 'l', 's', 'x', '2', 't', 'c', '2' };
+
+template<typename T>
+void
+write_manifest(str_t const& dir, Manifest<T> const& manifest)
 {
-	return i == std::numeric_limits<int64_t>::max();
+	// The manifest is written in a temporary file, then replaces the previous one at once.
+	auto const name{ dir + "/manifest.tmp" };
+	std::ofstream out{ name, std::ios::binary };
+	if (!out.is_open())
+		throw Exception{ "unable to open for output the “" + name + "” file" };
+	Manifest_header header{
+		{}, T::_info_.layout, sizeof(T), manifest.n, manifest.keys.size(), manifest.chunks.size()
+	};
+	std::memcpy(header.magic, manifest_magic, sizeof(header.magic));
+	out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+	out.write(reinterpret_cast<char const*>(manifest.keys.data()),
+	          manifest.keys.size() * sizeof(uint64_t));
+	out.write(reinterpret_cast<char const*>(manifest.chunks.data()),
+	          manifest.chunks.size() * sizeof(Chunk<T>));
+	if (!out)
+		throw Exception{ "unable to write the “" + name + "” file" };
+	out.close();
+	std::filesystem::rename(name, dir + "/manifest");
 }
-bool
-missing(double x)
+template<typename T>
+Manifest<T>
+read_manifest(str_t const& dir)
 {
-	return std::isnan(x);
+	auto const name{ dir + "/manifest" };
+	std::ifstream in{ name, std::ios::binary };
+	if (!in.is_open())
+		throw Exception{ "unable to open for input the “" + name + "” file (chunks not built?)" };
+	Manifest_header header;
+	in.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!in || (std::memcmp(header.magic, manifest_magic, sizeof(header.magic)) != 0))
+		throw Exception{ "the “" + name + "” file is not a manifest (file corrupted?)" };
+	if ((header.layout != T::_info_.layout) || (header.size != sizeof(T)))
+		throw Exception{ "the chunks in “" + dir + "” were not built with the current “" +
+			               T::_info_.struct_name + "” struct (chunks not rebuilt?)" };
+	Manifest<T> rvo{ header.n,
+		               std::vector<uint64_t>(header.nr_keys),
+		               std::vector<Chunk<T>>(header.nr_chunks) };
+	in.read(reinterpret_cast<char*>(rvo.keys.data()), rvo.keys.size() * sizeof(uint64_t));
+	in.read(reinterpret_cast<char*>(rvo.chunks.data()), rvo.chunks.size() * sizeof(Chunk<T>));
+	if (!in)
+		throw Exception{ "unable to read the “" + name + "” file (file corrupted?)" };
+	return rvo;
 }
-// auto const N { not_missing(table, &Row::member) };
-template<typename T, typename U>
-size_t
-not_missing(std::vector<T> const& table, U T::*m_ptr)
+
+template<typename T>
+str_t
+get_chunk_name(str_t const& dir, Chunk<T> const& chunk)
 {
-	size_t N{ 0 };
-	for (auto const& row : table)
-		if (!missing(row.*m_ptr))
-			++N;
-	return N;
+	char hash[17];
+	std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(chunk.hash));
+	return dir + '/' + std::to_string(chunk.id) + '-' + hash + ".gz";
 }
 template<typename T>
-size_t
-num_obs(std::vector<T> const& table, T const& row)
+str_t
+get_dir(str_t const& dir_name)
 {
-	assert(&row >= &table[0]);
-	return &row - &table[0];
-}
-// index(table, &Row::member, key)
-template<typename T, typename U>
-size_t
-index(std::vector<T> const& table, U T::*m_ptr, U const& key)
-{
-	// The maps are stored in a static main map. In case of miss, the map is created on the fly and
-	// putted in the cache. Otherwise, the map in cache is used. The key of the main map is the adress
-	// of the first observation of the table and the offset of the data member.
-	static std::map<std::pair<T const*, size_t>, std::map<U, size_t>> maps;
-	auto const offset{ size_t(reinterpret_cast<char const*>(&(table[0].*m_ptr)) -
-		                        reinterpret_cast<char const*>(&table[0])) };
-	auto const map_key{ std::make_pair(&table[0], offset) };
-	auto const it{ maps.find(map_key) };
-	if (it == std::cend(maps)) {
-		std::map<U, size_t> tmp;
-		for (auto const& row : table)
-			tmp[row.*m_ptr] = &row - &table[0];
-		maps[map_key] = tmp;
-		auto const it_key{ tmp.find(key) };
-		if (it_key == std::cend(tmp))
-			throw Exception{ "key “" + std::to_string(key) + "“ not found" };
-		return it_key->second;
-	}
-	auto const it_key{ it->second.find(key) };
-	if (it_key == std::cend(it->second))
-		throw Exception{ "key “" + std::to_string(key) + "“ not found" };
-	return it_key->second;
+	return (dir_name.empty() ? str_t{} : (dir_name + '/')) + T::_info_.file_name;
 }
-//  xt::index(table, &Row::member, key, &Row::get_member)
-template<typename T, typename U, typename V>
-V
-index(std::vector<T> const& table, U T::*m_ptr, U const& key, V T::*m_get_ptr)
+
+// Unmap a mapping on destruction (RAII).
+struct Mapping
+{
+	Mapping(void* ptr, size_t size)
+	  : ptr_(ptr)
+	  , size_(size)
+	{}
+	Mapping(Mapping const&) = delete;
+	Mapping& operator=(Mapping const&) = delete;
+	~Mapping()
+	{
+		if (ptr_ != MAP_FAILED)
+			// Do not check the return code as is bad to throw an exception in a destructor...
+			munmap(ptr_, size_);
+	}
+	void* ptr_;
+	size_t size_;
+};
+// Map a whole file read-only, with its pages loaded.
+std::shared_ptr<Mapping const>
+map_file(str_t const& file_name)
 {
-	return table[index(table, m_ptr, key)].*m_get_ptr;
+	auto const fd{ open(file_name.c_str(), O_RDONLY) };
+	if (fd < 0)
+		throw Exception{ "unable to open for input the “" + file_name + "” file (" +
+			               std::strerror(errno) + ')' };
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		throw Exception{ "unable to get the size of the “" + file_name + "” file" };
+	}
+	void* const ptr{ (st.st_size == 0) ? MAP_FAILED
+		                                 : mmap(nullptr,
+		                                        size_t(st.st_size),
+		                                        PROT_READ,
+		                                        MAP_SHARED | MAP_POPULATE,
+		                                        fd,
+		                                        0) };
+	close(fd);
+	if (ptr == MAP_FAILED)
+		throw Exception{ "unable to map the “" + file_name + "” file" };
+	return std::make_shared<Mapping const>(ptr, size_t(st.st_size));
 }
-// std::cout << freq(table, &Row::member, name);
-template<typename T, typename U>
+
+// A pool of threads which steal the tasks of each other: each thread pops the last task of its own
+// queue, or steals the first task of the queue of another thread.
+class Pool
+{
+public:
+	Pool(size_t nr_threads)
+	  : queues_(std::max(size_t(1), nr_threads))
+	{
+		for (size_t i{ 0 }; i < queues_.size(); ++i)
+			threads_.emplace_back([this, i]() { work(i); });
+	}
+	~Pool()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex_ };
+			stop_ = true;
+		}
+		cv_.notify_all();
+		for (auto& thread : threads_)
+			thread.join();
+	}
+	size_t size() const { return threads_.size(); }
+	// Run f(i) for i in [0, n) and wait for the end of the tasks; the calling thread runs tasks while
+	// waiting, so run can be called within a task. After an exception, the tasks not yet started are
+	// skipped and the first exception is rethrown on the calling thread.
+	template<typename F>
+	void run(size_t n, F const& f)
+	{
+		if (n == 0)
+			return;
+		auto const batch{ std::make_shared<Batch>() };
+		batch->remaining = n;
+		for (size_t i{ 0 }; i < n; ++i)
+			push([batch, &f, i]() {
+				if (!batch->failed) {
+					try {
+						f(i);
+					} catch (...) {
+						std::lock_guard<std::mutex> lock{ batch->mutex };
+						if (!batch->failed)
+							batch->error = std::current_exception(), batch->failed = true;
+					}
+				}
+				std::lock_guard<std::mutex> lock{ batch->mutex };
+				if (--batch->remaining == 0)
+					batch->cv.notify_all();
+			});
+		while (true) {
+			if (auto task{ pop() }) {
+				task();
+				continue;
+			}
+			std::unique_lock<std::mutex> lock{ batch->mutex };
+			if (batch->remaining == 0)
+				break;
+			// Wake up from time to time to help with the tasks pushed by the other tasks.
+			batch->cv.wait_for(lock, std::chrono::milliseconds(1));
+		}
+		if (batch->error)
+			std::rethrow_exception(batch->error);
+	}
+	// Run f later, on a thread of the pool: the future gives its end or its exception.
+	std::future<void> post(std::function<void()> f)
+	{
+		auto const task{ std::make_shared<std::packaged_task<void()>>(std::move(f)) };
+		auto rvo{ task->get_future() };
+		push([task]() { (*task)(); });
+		return rvo;
+	}
+	// Wait for the future, running the tasks of the pool meanwhile, so a task can wait for another
+	// one.
+	void wait(std::future<void> const& future)
+	{
+		while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			if (auto task{ pop() })
+				task();
+			else
+				future.wait_for(std::chrono::milliseconds(1));
+	}
+
+private:
+	struct Batch
+	{
+		std::mutex mutex;
+		std::condition_variable cv;
+		size_t remaining;
+		std::atomic<bool> failed{ false };
+		std::exception_ptr error;
+	};
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+	// The index of the thread within its pool.
+	static size_t& index()
+	{
+		thread_local size_t rvo{ std::numeric_limits<size_t>::max() };
+		return rvo;
+	}
+	static Pool*& owner()
+	{
+		thread_local Pool* rvo{ nullptr };
+		return rvo;
+	}
+	bool own() const { return owner() == this; }
+	void push(std::function<void()> task)
+	{
+		auto& queue{ queues_[own() ? index() : (next_++ % queues_.size())] };
+		{
+			std::lock_guard<std::mutex> lock{ queue.mutex };
+			queue.tasks.push_back(std::move(task));
+		}
+		{
+			std::lock_guard<std::mutex> lock{ mutex_ };
+			++pending_;
+		}
+		cv_.notify_one();
+	}
+	std::function<void()> pop()
+	{
+		auto const first{ own() ? index() : 0 };
+		for (size_t k{ 0 }; k < queues_.size(); ++k) {
+			auto& queue{ queues_[(first + k) % queues_.size()] };
+			std::lock_guard<std::mutex> lock{ queue.mutex };
+			if (queue.tasks.empty())
+				continue;
+			std::function<void()> rvo;
+			if (k == 0 && own())
+				rvo = std::move(queue.tasks.back()), queue.tasks.pop_back();
+			else
+				rvo = std::move(queue.tasks.front()), queue.tasks.pop_front();
+			--pending_;
+			return rvo;
+		}
+		return {};
+	}
+	void work(size_t i)
+	{
+		index() = i, owner() = this;
+		while (true) {
+			if (auto task{ pop() }) {
+				task();
+				continue;
+			}
+			std::unique_lock<std::mutex> lock{ mutex_ };
+			cv_.wait(lock, [&]() { return stop_ || (pending_ > 0); });
+			if (stop_ && (pending_ == 0))
+				return;
+		}
+	}
+
+	std::vector<Queue> queues_;
+	std::vector<std::thread> threads_;
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	std::atomic<size_t> pending_{ 0 };
+	std::atomic<size_t> next_{ 0 };
+	bool stop_{ false };
+};
+
+std::unique_ptr<Pool>&
+get_pool_ptr()
+{
+	static std::unique_ptr<Pool> rvo;
+	return rvo;
+}
+std::mutex&
+get_pool_mutex()
+{
+	static std::mutex rvo;
+	return rvo;
+}
+// The pool shared by build<T>, read<T> and the parallel helpers. By default, it has as many threads
+// as cores.
+Pool&
+pool()
+{
+	std::lock_guard<std::mutex> lock{ get_pool_mutex() };
+	auto& ptr{ get_pool_ptr() };
+	if (!ptr)
+		ptr = std::make_unique<Pool>(std::thread::hardware_concurrency());
+	return *ptr;
+}
+// Set the number of threads of the shared pool; not to be called while the pool runs tasks.
+void
+set_concurrency(size_t nr_threads)
+{
+	std::lock_guard<std::mutex> lock{ get_pool_mutex() };
+	get_pool_ptr() = std::make_unique<Pool>(nr_threads);
+}
+
+namespace internals {
+// A field is an int, a finite double or a string, as Excel types the cells when it opens the file;
+// an empty field is an empty string, like an empty cell.
+fd_read_xlsx::cell_t
+get_cell(str_t& field)
+{
+	auto const first{ field.data() };
+	auto const last{ first + field.size() };
+	if (!field.empty() && (std::isdigit(static_cast<unsigned char>(field[0])) || (field[0] == '-') ||
+	                       (field[0] == '.'))) {
+		int64_t i;
+		if (auto const [ptr, ec]{ std::from_chars(first, last, i) };
+		    (ec == std::errc{}) && (ptr == last))
+			return i;
+		double x;
+		if (auto const [ptr, ec]{ std::from_chars(first, last, x) };
+		    (ec == std::errc{}) && (ptr == last) && std::isfinite(x))
+			return x;
+	}
+	return std::move(field);
+}
+// Parse the rows between first and last: first is the start of a row, last is the start of a row
+// or the end of the file. The blank lines are skipped. complete is false if the last row does not
+// end with a newline before last, as when last is inside a quoted field.
+fd_read_xlsx::table_t
+parse_rows(char const* p, char const* const last, char separator, bool& complete)
+{
+	fd_read_xlsx::table_t rvo;
+	complete = true;
+	while (p < last) {
+		std::vector<fd_read_xlsx::cell_t> row;
+		for (;;) {
+			str_t field;
+			// A quoted field, where a doubled quote is a quote.
+			if ((p < last) && (*p == '"')) {
+				for (++p; p < last; ++p)
+					if (*p != '"')
+						field += *p;
+					else if ((p + 1 < last) && (p[1] == '"'))
+						field += '"', ++p;
+					else {
+						++p;
+						break;
+					}
+			}
+			auto const start{ p };
+			while ((p < last) && (*p != separator) && (*p != '\n'))
+				++p;
+			// Chop the \r of a \r\n.
+			auto const end{ ((p > start) && (p[-1] == '\r') && ((p == last) || (*p == '\n'))) ? p - 1
+				                                                                                  : p };
+			field.append(start, end);
+			row.push_back(get_cell(field));
+			if ((p < last) && (*p == separator))
+				++p;
+			else
+				break;
+		}
+		complete = (p < last);
+		if (p < last)
+			++p;
+		if ((row.size() > 1) || !fd_read_xlsx::empty(row[0]))
+			rvo.push_back(std::move(row));
+	}
+	return rvo;
+}
+} // namespace internals
+
+// The table of a CSV file, or of a TSV one with '\t' as separator. The fields may be quoted, with
+// separators, newlines and doubled quotes inside; a leading UTF-8 BOM is skipped. The file is split
+// in parts parsed by the pool: a first pass counts the quotes of each part, so each part starts
+// after the first newline which is not quoted. A quote inside an unquoted field can make a part
+// start inside a quoted field: if a part does not end with its last row, the file is parsed again
+// by a single thread.
+fd_read_xlsx::table_t
+read_csv(fd_read_xlsx::Buffer const& buffer, char separator = ',')
+{
+	auto first{ static_cast<char const*>(buffer.data) };
+	auto size{ buffer.size };
+	if ((size >= 3) && (std::memcmp(first, "\xEF\xBB\xBF", 3) == 0))
+		first += 3, size -= 3;
+	if (size == 0)
+		return {};
+	auto const nr_parts{ std::clamp(size / (size_t(1) << 20), size_t(1), 4 * pool().size()) };
+	std::vector<size_t> quotes(nr_parts);
+	pool().run(nr_parts, [&](size_t k) {
+		quotes[k] = std::count(first + k * size / nr_parts, first + (k + 1) * size / nr_parts, '"');
+	});
+	// The start of each part, and the end of the last one.
+	std::vector<char const*> starts(nr_parts + 1, first + size);
+	starts[0] = first;
+	size_t nr_quotes{ 0 };
+	for (size_t k{ 1 }; k < nr_parts; ++k) {
+		nr_quotes += quotes[k - 1];
+		bool quoted{ nr_quotes % 2 == 1 };
+		for (auto p{ first + k * size / nr_parts }; p < first + size; ++p)
+			if (*p == '"')
+				quoted = !quoted;
+			else if ((*p == '\n') && !quoted) {
+				starts[k] = p + 1;
+				break;
+			}
+	}
+	std::vector<fd_read_xlsx::table_t> parts(nr_parts);
+	std::unique_ptr<bool[]> completes{ new bool[nr_parts] };
+	pool().run(nr_parts, [&](size_t k) {
+		parts[k] = internals::parse_rows(
+		  starts[k], std::max(starts[k], starts[k + 1]), separator, completes[k]);
+	});
+	for (size_t k{ 0 }; k + 1 < nr_parts; ++k)
+		if ((starts[k] > starts[k + 1]) || (!completes[k] && (starts[k + 1] < first + size))) {
+			bool complete;
+			return internals::parse_rows(first, first + size, separator, complete);
+		}
+	fd_read_xlsx::table_t rvo;
+	size_t n{ 0 };
+	for (auto const& part : parts)
+		n += part.size();
+	rvo.reserve(n);
+	for (auto& part : parts)
+		std::move(begin(part), end(part), back_inserter(rvo));
+	return rvo;
+}
+fd_read_xlsx::table_t
+read_csv(char const* const file_name, char separator = ',')
+{
+	if (std::filesystem::file_size(file_name) == 0)
+		return {};
+	auto const mapping{ map_file(file_name) };
+	return read_csv(fd_read_xlsx::Buffer{ mapping->ptr_, mapping->size_ }, separator);
+}
+
+namespace internals {
+std::pair<fd_read_xlsx::table_t, str_t>
+get_table_sheetname(char const* const file_name,
+                    char const* const sheet_name,
+                    fd_read_xlsx::Buffer const* const buffer)
+{
+	str_t const name{ file_name };
+	if (!has_extension(name, ".csv") && !has_extension(name, ".tsv"))
+		return buffer ? fd_read_xlsx::get_table_sheetname(*buffer, sheet_name)
+		              : fd_read_xlsx::get_table_sheetname(file_name, sheet_name);
+	if (sheet_name[0] != '\0')
+		throw Exception{ "the “" + name + "” file has no sheet “" + sheet_name + "”" };
+	// The name of the sheet is the base name of the file, so the names of the struct and of the
+	// file are the base name.
+	auto const separator{ has_extension(name, ".csv") ? ',' : '\t' };
+	return { buffer ? read_csv(*buffer, separator) : read_csv(file_name, separator),
+		       get_base_name(file_name) };
+}
+} // namespace internals
+
+template<typename T>
+void
+task_write(str_t const& file_name, std::vector<T> const& tcpp, size_t start, size_t end)
+{
+	if (start == end)
+		return;
+	// The chunk is written in a temporary file, so a chunk file is always complete; compression
+	// level 9.
+	auto const tmp_name{ file_name + ".tmp" };
+	auto out{ gzopen(tmp_name.c_str(), "wb9") };
+	if (out == NULL)
+		throw Exception{ "unable to open for output the “" + tmp_name + "” file" };
+	size_t const n =
+	  gzwrite(out, reinterpret_cast<char const*>(&tcpp[start]), (end - start) * sizeof(T));
+	auto const ret{ gzclose(out) };
+	if (n != (end - start) * sizeof(T))
+		throw Exception{ "unable to append the zipped stream into the “" + tmp_name + "” file" };
+	if (ret != Z_OK)
+		throw Exception{ "unable to close the “" + tmp_name + "” file" };
+	std::filesystem::rename(tmp_name, file_name);
+}
+uint64_t
+get_table_hash(std::vector<uint64_t> const& hashes)
+{
+	return hash(hashes.data(), hashes.size() * sizeof(uint64_t));
+}
+template<typename T>
+uint64_t
+get_table_hash(Manifest<T> const& manifest)
+{
+	std::vector<uint64_t> hashes;
+	for (auto const& chunk : manifest.chunks)
+		hashes.push_back(chunk.hash);
+	return get_table_hash(hashes);
+}
+// The file of the index of some columns: “index-1-3.idx”.
+str_t
+get_index_name(std::vector<uint64_t> const& columns)
+{
+	str_t rvo{ "index" };
+	for (auto const& j : columns)
+		rvo += '-' + std::to_string(j);
+	return rvo + ".idx";
+}
+std::vector<std::filesystem::path>
+get_index_paths(str_t const& dir)
+{
+	std::vector<std::filesystem::path> rvo;
+	for (auto const& entry : std::filesystem::directory_iterator{ dir })
+		if (entry.path().extension() == ".idx")
+			rvo.push_back(entry.path());
+	return rvo;
+}
+
+// Column of a data member.
+template<typename T, typename U>
+size_t
+get_column(U T::*m_ptr)
+{
+	size_t rvo{ nr_members<T> };
+	for_each_member<T>([&](auto m, size_t j) {
+		if constexpr (std::is_same_v<decltype(m), U T::*>)
+			if (m == m_ptr)
+				rvo = j;
+	});
+	if (rvo == nr_members<T>)
+		throw Exception{ "the pointer is not a pointer to a data member of “" +
+			               str_t{ T::_info_.struct_name } + "”" };
+	return rvo;
+}
+
+// Run f(start, end) by the pool on the blocks of chunk_rows rows of [0, n).
+template<typename F>
+void
+for_each_block(size_t n, F const& f)
+{
+	// A single block is run by the caller.
+	if (n <= chunk_rows) {
+		if (n > 0)
+			f(0, n);
+		return;
+	}
+	pool().run((n + chunk_rows - 1) / chunk_rows, [&](size_t k) {
+		f(k * chunk_rows, std::min(n, (k + 1) * chunk_rows));
+	});
+}
+
+// Stable sort of v by the pool: the parts are sorted, then merged two by two.
+template<typename V, typename Less>
+void
+parallel_sort(V& v, Less const& less)
+{
+	// Some parts by thread, to balance the load.
+	auto const nr_parts{ std::max(size_t(1), std::min(4 * pool().size(), v.size() / 1024)) };
+	std::vector<size_t> bounds;
+	for (size_t i{ 0 }; i <= nr_parts; ++i)
+		bounds.push_back(v.size() * i / nr_parts);
+	pool().run(nr_parts, [&](size_t i) {
+		std::stable_sort(begin(v) + bounds[i], begin(v) + bounds[i + 1], less);
+	});
+	while (bounds.size() > 2) {
+		pool().run((bounds.size() - 1) / 2, [&](size_t k) {
+			std::inplace_merge(
+			  begin(v) + bounds[2 * k], begin(v) + bounds[2 * k + 1], begin(v) + bounds[2 * k + 2], less);
+		});
+		std::vector<size_t> next;
+		for (size_t i{ 0 }; i + 1 < bounds.size(); i += 2)
+			next.push_back(bounds[i]);
+		next.push_back(bounds.back());
+		bounds = next;
+	}
+}
+
+namespace internals {
+// Stable scatter of [0, n) by the digits in [0, nr_digits), by the pool: the counts of the digits
+// by block, their offsets, then move(i, position). Returns the bounds of the digits, or nothing
+// (and nothing is moved) if all the digits are the same.
+template<typename Digit, typename Move>
+std::vector<size_t>
+scatter(size_t n, size_t nr_digits, Digit const& digit, Move const& move)
+{
+	std::vector<size_t> counts((n + chunk_rows - 1) / chunk_rows * nr_digits);
+	for_each_block(n, [&](size_t start, size_t end) {
+		auto const count{ &counts[start / chunk_rows * nr_digits] };
+		for (auto i{ start }; i < end; ++i)
+			++count[digit(i)];
+	});
+	std::vector<size_t> rvo(nr_digits + 1, n);
+	size_t offset{ 0 };
+	for (size_t d{ 0 }; d < nr_digits; ++d) {
+		rvo[d] = offset;
+		for (auto k{ d }; k < counts.size(); k += nr_digits)
+			offset += std::exchange(counts[k], offset);
+		if (offset - rvo[d] == n)
+			return {};
+	}
+	for_each_block(n, [&](size_t start, size_t end) {
+		auto const position{ &counts[start / chunk_rows * nr_digits] };
+		for (auto i{ start }; i < end; ++i)
+			move(i, position[digit(i)]++);
+	});
+	return rvo;
+}
+
+// The keys of the LSD radix sort: their order as unsigned integers is the order of less.
+inline uint64_t
+radix_key(int64_t i)
+{
+	return uint64_t(i) ^ (uint64_t(1) << 63);
+}
+inline uint64_t
+radix_key(double x)
+{
+	if (std::isnan(x))
+		return std::numeric_limits<uint64_t>::max();
+	// -0 is equal to 0.
+	if (x == 0)
+		x = 0;
+	uint64_t u;
+	std::memcpy(&u, &x, sizeof u);
+	return (u >> 63) ? ~u : u | (uint64_t(1) << 63);
+}
+// Stable sort of the ids by the keys, 8 bits at a time. A pass is skipped if all the keys have
+// the same digit.
+inline void
+lsd_sort(std::vector<uint64_t>& keys, std::vector<size_t>& ids)
+{
+	std::vector<uint64_t> next_keys(keys.size());
+	std::vector<size_t> next_ids(ids.size());
+	for (int shift{ 0 }; shift < 64; shift += 8) {
+		auto const bounds{ scatter(
+		  keys.size(),
+		  256,
+		  [&](size_t i) { return (keys[i] >> shift) & 255; },
+		  [&](size_t i, size_t j) { next_keys[j] = keys[i], next_ids[j] = ids[i]; }) };
+		if (!bounds.empty())
+			keys.swap(next_keys), ids.swap(next_ids);
+	}
+}
+// Stable sort of the ids by the strings, from the char depth: 256 buckets for the chars, and a
+// last one for the missing strings. The large buckets are sorted by the pool. The chars after the
+// first null char are null: the bucket of the strings which ended is not sorted, nor a bucket
+// whose strings are all equal, which is checked once a pass moves nothing.
+template<typename T, size_t N>
+void
+msd_sort(T const* rows,
+         std::array<char, N> T::*m_ptr,
+         size_t* ids,
+         size_t* buffer,
+         size_t n,
+         size_t depth)
+{
+	if (n < 64) {
+		std::stable_sort(
+		  ids, ids + n, [&](size_t i, size_t j) { return less(rows[i].*m_ptr, rows[j].*m_ptr); });
+		return;
+	}
+	std::vector<size_t> bounds;
+	bool checked{ false };
+	for (; depth < N; ++depth) {
+		bounds = scatter(
+		  n,
+		  257,
+		  [&](size_t i) {
+			  auto const& str{ rows[ids[i]].*m_ptr };
+			  return (depth == 0) && missing(str) ? 256 : size_t(static_cast<unsigned char>(str[depth]));
+		  },
+		  [&](size_t i, size_t j) { buffer[j] = ids[i]; });
+		if (!bounds.empty())
+			break;
+		auto const& first{ rows[ids[0]].*m_ptr };
+		if (missing(first) || (first[depth] == '\0'))
+			return;
+		if (!checked) {
+			checked = true;
+			std::atomic<bool> equal{ true };
+			for_each_block(n, [&](size_t start, size_t end) {
+				for (auto i{ start }; (i < end) && equal.load(std::memory_order_relaxed); ++i)
+					if (std::memcmp(first.data() + depth, (rows[ids[i]].*m_ptr).data() + depth, N - depth))
+						equal = false;
+			});
+			if (equal)
+				return;
+		}
+	}
+	if (depth == N)
+		return;
+	for_each_block(n, [&](size_t start, size_t end) {
+		std::copy(buffer + start, buffer + end, ids + start);
+	});
+	auto const sort_bucket{ [&](size_t d) {
+		if ((d > 0) && (d < 256) && (depth + 1 < N))
+			msd_sort(
+			  rows, m_ptr, ids + bounds[d], buffer + bounds[d], bounds[d + 1] - bounds[d], depth + 1);
+	} };
+	if (n > chunk_rows)
+		pool().run(256, sort_bucket);
+	else
+		for (size_t d{ 0 }; d < 256; ++d)
+			sort_bucket(d);
+}
+template<typename T, typename A, typename U>
+void
+radix_sort_ids(std::vector<T, A> const& table, U T::*m_ptr, std::vector<size_t>& ids)
+{
+	if constexpr (std::is_arithmetic_v<U>) {
+		std::vector<uint64_t> keys(ids.size());
+		for_each_block(ids.size(), [&](size_t start, size_t end) {
+			for (auto i{ start }; i < end; ++i)
+				keys[i] = radix_key(table[ids[i]].*m_ptr);
+		});
+		lsd_sort(keys, ids);
+	} else {
+		std::vector<size_t> buffer(ids.size());
+		msd_sort(table.data(), m_ptr, ids.data(), buffer.data(), ids.size(), 0);
+	}
+}
+// From the last key to the first one.
+template<typename T, typename A, typename Tuple, size_t... I>
+void
+radix_sort_ids(std::vector<T, A> const& table,
+               Tuple const& m_ptrs,
+               std::vector<size_t>& ids,
+               std::index_sequence<I...>)
+{
+	(radix_sort_ids(table, std::get<sizeof...(I) - 1 - I>(m_ptrs), ids), ...);
+}
+} // namespace internals
+
+// auto const ids{ radix_permutation(table, &Row::date, &Row::id) }; // table[ids[0]] is the first
+// radix_sort(table, &Row::date, &Row::id);
+// The rows are ordered by the keys like less (the missing values are the last ones), then by their
+// position. The ids of the rows are sorted, a key at a time from the last one: by LSD radix on the
+// bytes of the numbers, mapped to unsigned integers, and by MSD radix on the chars of the strings.
+// Then the rows are moved once.
+template<typename T, typename A, typename... Us>
+std::vector<size_t>
+radix_permutation(std::vector<T, A> const& table, Us T::*... m_ptrs)
+{
+	std::vector<size_t> rvo(table.size());
+	for_each_block(rvo.size(), [&](size_t start, size_t end) {
+		std::iota(begin(rvo) + start, begin(rvo) + end, start);
+	});
+	internals::radix_sort_ids(
+	  table, std::make_tuple(m_ptrs...), rvo, std::index_sequence_for<Us...>{});
+	return rvo;
+}
+// The row i of the result is the row ids[i] of the table.
+template<typename T, typename A>
+void
+apply_permutation(std::vector<T, A>& table, std::vector<size_t> const& ids)
+{
+	assert(ids.size() == table.size());
+	std::vector<T, A> rvo(table.size(), table.get_allocator());
+	for_each_block(rvo.size(), [&](size_t start, size_t end) {
+		for (auto i{ start }; i < end; ++i)
+			rvo[i] = std::move(table[ids[i]]);
+	});
+	table.swap(rvo);
+}
+// The same, in place, with a bit by row: the cycles of the permutation are followed by a single
+// thread.
+template<typename T, typename A>
+void
+apply_permutation_in_place(std::vector<T, A>& table, std::vector<size_t> const& ids)
+{
+	assert(ids.size() == table.size());
+	std::vector<bool> done(table.size(), false);
+	for (size_t i{ 0 }; i < table.size(); ++i) {
+		if (done[i])
+			continue;
+		auto row{ std::move(table[i]) };
+		auto j{ i };
+		for (; ids[j] != i; j = ids[j])
+			table[j] = std::move(table[ids[j]]), done[j] = true;
+		table[j] = std::move(row), done[j] = true;
+	}
+}
+template<typename T, typename A, typename... Us>
+void
+radix_sort(std::vector<T, A>& table, Us T::*... m_ptrs)
+{
+	apply_permutation(table, radix_permutation(table, m_ptrs...));
+}
+
+// The options of build<T>, applied to the plan of the build in the order of the arguments.
+template<typename T, typename... Us>
+class Index;
+
+template<typename T>
+struct Plan
+{
+	std::vector<uint64_t> keys;
+	// The permutation which sorts the rows.
+	std::function<std::vector<size_t>(std::vector<T> const&)> sort;
+	// Save an index of the rows, given the directory and the hash of the table, and return its path.
+	std::vector<
+	  std::function<std::filesystem::path(std::vector<T> const&, str_t const&, uint64_t)>>
+	  indexes;
+	// In bytes, none if 0.
+	size_t memory_budget{ 0 };
+	// Parse the workbook even if its columns are stored by init.
+	bool parse_source{ false };
+};
+
+// build<Row>("file.xlsx", "", sort_by(&Row::date, &Row::id))
+// The rows are sorted by the keys, then by their order in the sheet.
+template<typename T, typename... Us>
+struct Sort_by
+{
+	std::tuple<Us T::*...> m_ptrs;
+	void apply(Plan<T>& plan) const
+	{
+		plan.keys.clear();
+		std::apply([&](auto... m_ptr) { (plan.keys.push_back(get_column(m_ptr)), ...); }, m_ptrs);
+		plan.sort = [m_ptrs = m_ptrs](std::vector<T> const& tcpp) {
+			return std::apply([&](auto... m_ptr) { return radix_permutation(tcpp, m_ptr...); },
+			                  m_ptrs);
+		};
+	}
+};
+template<typename T, typename... Us>
+Sort_by<T, Us...>
+sort_by(Us T::*... m_ptrs)
+{
+	return { { m_ptrs... } };
+}
+
+// build<Row>("file.xlsx", "", index_on(&Row::date, &Row::id))
+// The index is saved next to the chunks and mapped by load_index<Row>(dir_name, &Row::date,
+// &Row::id).
+template<typename T, typename... Us>
+struct Index_on
+{
+	std::tuple<Us T::*...> m_ptrs;
+	void apply(Plan<T>& plan) const
+	{
+		plan.indexes.push_back(
+		  [m_ptrs = m_ptrs](std::vector<T> const& tcpp, str_t const& dir, uint64_t table_hash) {
+			  return std::apply(
+			    [&](auto... m_ptr) {
+				    std::filesystem::path const path{ dir + '/' +
+					                                    get_index_name({ get_column(m_ptr)... }) };
+				    Index<T, Us...>{ tcpp, m_ptr... }.save(path, table_hash);
+				    return path;
+			    },
+			    m_ptrs);
+		  });
+	}
+};
+template<typename T, typename... Us>
+Index_on<T, Us...>
+index_on(Us T::*... m_ptrs)
+{
+	return { { m_ptrs... } };
+}
+
+// build<Row>("file.xlsx", "", memory_budget(size_t(8) << 30))
+// The main structures of the build must hold in the budget, in bytes: the table of the cells of the
+// sheet, the rows, and the buffers of the sort. If the sorted rows cannot be copied within the
+// budget, they are permuted in place, by a single thread; if the cells and the rows, or the rows
+// and the buffers of the sort, do not fit, build fails before the rows are allocated. The size of
+// the cells is known only once the workbook is parsed: the parse itself is not bounded.
+struct Memory_budget
+{
+	size_t bytes;
+	template<typename T>
+	void apply(Plan<T>& plan) const
+	{
+		plan.memory_budget = bytes;
+	}
+};
+Memory_budget
+memory_budget(size_t bytes)
+{
+	return { bytes };
+}
+
+// build<Row>("file.xlsx", "", parse_source())
+// The rows are read from the workbook, not from the columns stored by init.
+struct Parse_source
+{
+	template<typename T>
+	void apply(Plan<T>& plan) const
+	{
+		plan.parse_source = true;
+	}
+};
+Parse_source
+parse_source()
+{
+	return {};
+}
+
+namespace internals {
+// The chars of a short string are in the string object.
+bool
+is_in_place(str_t const& str)
+{
+	auto const object{ reinterpret_cast<uintptr_t>(&str) };
+	auto const chars{ reinterpret_cast<uintptr_t>(str.data()) };
+	return (object <= chars) && (chars < object + sizeof(str_t));
+}
+// The bytes of the table of the cells, with the strings which are not in place.
+size_t
+get_bytes(fd_read_xlsx::table_t const& table)
+{
+	std::vector<size_t> sizes((table.size() + chunk_rows - 1) / chunk_rows);
+	for_each_block(table.size(), [&](size_t start, size_t end) {
+		size_t bytes{ 0 };
+		for (auto i{ start }; i < end; ++i) {
+			bytes += sizeof(table[i]) + table[i].capacity() * sizeof(fd_read_xlsx::cell_t);
+			for (auto const& cell : table[i])
+				if (auto const str{ std::get_if<str_t>(&cell) }; str && !is_in_place(*str))
+					bytes += str->capacity() + 1;
+		}
+		sizes[start / chunk_rows] = bytes;
+	});
+	return std::accumulate(begin(sizes), end(sizes), size_t{ 0 });
+}
+void
+check_budget(size_t budget, str_t const& what, size_t bytes)
+{
+	if ((budget > 0) && (bytes > budget))
+		throw Exception{ "the memory budget of " + std::to_string(budget) + " bytes is exceeded: " +
+			               what + " would take " + std::to_string(bytes) + " bytes" };
+}
+// The rows filled from the columns written by init, if they were written from the same workbook and
+// sheet for the same struct.
+template<typename T>
+std::optional<std::vector<T>>
+read_columns(char const* const xlsx_file_name, char const* const sheet_name, size_t budget)
+{
+	auto const name{ get_columns_name(xlsx_file_name, T::_info_.file_name) };
+	if (!std::filesystem::exists(name))
+		return {};
+	auto const mapping{ map_file(name) };
+	auto const bytes{ static_cast<char const*>(mapping->ptr_) };
+	// A truncated file is not used, like the columns of another workbook.
+	Columns_header header;
+	if (mapping->size_ < sizeof(header))
+		return {};
+	std::memcpy(&header, bytes, sizeof(header));
+	auto const [source_hash, source_size, source_time]{ get_source_hash_size_time(xlsx_file_name) };
+	auto const sheet_hash{ get_sheet_hash(sheet_name) };
+	if ((std::memcmp(header.magic, columns_magic, sizeof(header.magic)) != 0) ||
+	    (header.layout != T::_info_.layout) || (header.nr_cols != nr_members<T>) ||
+	    (header.source_hash != source_hash) || (header.source_size != source_size) ||
+	    (header.source_time != source_time) ||
+	    ((header.sheet_hash != sheet_hash) && (header.sheetname_hash != sheet_hash)))
+		return {};
+	std::array<uint64_t, nr_members<T>> widths;
+	std::array<size_t, nr_members<T>> offsets;
+	auto offset{ sizeof(header) + sizeof(widths) };
+	if ((mapping->size_ < offset) || (header.n > mapping->size_))
+		return {};
+	std::memcpy(widths.data(), bytes + sizeof(header), sizeof(widths));
+	bool same{ true };
+	for_each_member<T>([&](auto m_ptr, size_t j) {
+		same = same && (widths[j] == sizeof(T{}.*m_ptr));
+		offsets[j] = offset;
+		offset += get_padded(header.n * sizeof(T{}.*m_ptr));
+	});
+	if (!same || (mapping->size_ < offset))
+		return {};
+	check_budget(budget, "the columns and the rows", mapping->size_ + header.n * sizeof(T));
+	std::vector<T> rvo(header.n);
+	for_each_block(rvo.size(), [&](size_t start, size_t end) {
+		for_each_member<T>([&](auto m_ptr, size_t j) {
+			auto const column{ bytes + offsets[j] };
+			for (auto i{ start }; i < end; ++i)
+				std::memcpy(&(rvo[i].*m_ptr), column + i * widths[j], widths[j]);
+		});
+	});
+	return rvo;
+}
+} // namespace internals
+
+namespace internals {
+// Build the chunks of the sheet in the dir directory.
+template<typename T>
+void
+build_into(char const* const xlsx_file_name,
+           char const* const sheet_name,
+           str_t const& dir,
+           Plan<T> const& plan,
+           fd_read_xlsx::Buffer const* const buffer = nullptr)
+{
+	Recorder recorder{ "build", xlsx_file_name };
+	auto const budget{ plan.memory_budget };
+	std::vector<T> tcpp;
+	auto const use_columns{ !buffer && !plan.parse_source };
+	if (auto columns{ use_columns ? read_columns<T>(xlsx_file_name, sheet_name, budget)
+	                              : std::nullopt }) {
+		progress() << "Reading the columns of “" << dir << "”...\n";
+		tcpp = std::move(*columns);
+		recorder.hold("rows", tcpp.size() * sizeof(T));
+		recorder.end_phase("read_columns");
+	} else {
+		progress() << "Reading “" << xlsx_file_name << "”...\n";
+		auto table{ get_table_sheetname(xlsx_file_name, sheet_name, buffer).first };
+		if (table.empty())
+			throw Exception{ "the worksheet is empty" };
+		recorder.add_cells(get_nr_cells(table));
+		auto const rows_bytes{ (table.size() - 1) * sizeof(T) };
+		if ((budget > 0) || recorder.accounting()) {
+			auto const cells_bytes{ get_bytes(table) };
+			recorder.hold("cells", cells_bytes);
+			check_budget(budget, "the cells and the rows", cells_bytes + rows_bytes);
+		}
+		recorder.end_phase("read_xlsx");
+		tcpp.reserve(table.size() - 1);
+		progress() << "Copying “" << dir << "”...\n";
+		for (size_t i{ 1 }; i < table.size(); ++i)
+			tcpp.push_back(T{ table[i] });
+		// The cells are not needed any more.
+		fd_read_xlsx::table_t{}.swap(table);
+		recorder.hold("cells", 0), recorder.hold("rows", rows_bytes);
+		recorder.end_phase("convert");
+	}
+	auto const rows_bytes{ tcpp.size() * sizeof(T) };
+	recorder.add_rows(tcpp.size(), sizeof(T));
+	if (plan.sort) {
+		progress() << "Sorting “" << dir << "”...\n";
+		// The ids, and the keys and the ids of a pass of the radix sort.
+		auto const sort_bytes{ 4 * sizeof(size_t) * tcpp.size() };
+		check_budget(budget, "the rows and the sort buffers", rows_bytes + sort_bytes);
+		recorder.hold("sort", sort_bytes);
+		auto const ids{ plan.sort(tcpp) };
+		recorder.hold("sort", ids.size() * sizeof(size_t));
+		if ((budget > 0) && (2 * rows_bytes + ids.size() * sizeof(size_t) > budget))
+			apply_permutation_in_place(tcpp, ids);
+		else {
+			recorder.hold("copy", rows_bytes);
+			apply_permutation(tcpp, ids);
+		}
+		recorder.hold("sort", 0), recorder.hold("copy", 0);
+		recorder.end_phase("sort");
+	}
+
+	progress() << "Zipping “" << dir << "”...\n";
+	// Be careful to create the directory.
+	if (!std::filesystem::exists(dir))
+		if (!std::filesystem::create_directories(dir))
+			throw Exception{ "unable to create “" + dir + "” directory" };
+
+	// The previous chunks, if any, which were built with the current struct.
+	auto const previous{ [&]() {
+		try {
+			return read_manifest<T>(dir);
+		} catch (Exception const&) {
+			return Manifest<T>{};
+		}
+	}() };
+	auto const unchanged{ [&](Chunk<T> const& chunk) {
+		if (chunk.id >= previous.chunks.size())
+			return false;
+		auto const& prev{ previous.chunks[chunk.id] };
+		return (prev.start == chunk.start) && (prev.n == chunk.n) && (prev.hash == chunk.hash) &&
+		       std::filesystem::exists(get_chunk_name(dir, chunk));
+	} };
+
+	// One task by chunk.
+	auto const nr_chunks{ (tcpp.size() + chunk_rows - 1) / chunk_rows };
+	Manifest<T> manifest{ tcpp.size(), plan.keys, std::vector<Chunk<T>>(nr_chunks) };
+	std::atomic<size_t> nr_written{ 0 };
+	pool().run(nr_chunks, [&](size_t id) {
+		auto const start{ id * chunk_rows };
+		auto const end{ std::min(start + chunk_rows, tcpp.size()) };
+		manifest.chunks[id] = get_chunk(tcpp, id, start, end);
+		if (!unchanged(manifest.chunks[id])) {
+			auto const name{ get_chunk_name(dir, manifest.chunks[id]) };
+			recorder.time_chunk([&]() { task_write<T>(name, tcpp, start, end); }, name);
+			++nr_written;
+		}
+	});
+	recorder.end_phase("zip");
+	// An index replaces the previous one at once and is checked against the hash of the table at
+	// load time, so it cannot be mixed with the previous chunks.
+	std::vector<std::filesystem::path> kept;
+	if (!plan.indexes.empty()) {
+		progress() << "Indexing “" << dir << "”...\n";
+		for (auto const& save : plan.indexes)
+			kept.push_back(save(tcpp, dir, get_table_hash(manifest)));
+		recorder.end_phase("index");
+	}
+	write_manifest(dir, manifest);
+	progress() << nr_written << " of " << nr_chunks << " chunks of “" << dir << "” zipped...\n";
+	// Only now, remove the chunks and the indexes of the previous manifest which are not in the new
+	// one, and the temporary files of an interrupted build.
+	for (auto const& chunk : manifest.chunks)
+		kept.push_back(get_chunk_name(dir, chunk));
+	for (auto const& entry : std::filesystem::directory_iterator{ dir }) {
+		auto const& path{ entry.path() };
+		auto const extension{ path.extension() };
+		if (entry.is_regular_file() &&
+		    ((extension == ".gz") || (extension == ".idx") || (extension == ".tmp")) &&
+		    (std::find(cbegin(kept), cend(kept), path) == cend(kept)))
+			std::filesystem::remove(path);
+	}
+	recorder.end_phase("manifest");
+	recorder.finish();
+}
+} // namespace internals
+
+template<typename T, typename... Options>
+void
+build(char const* const xlsx_file_name,
+      char const* const sheet_name = "",
+      Options const&... options)
+{
+	Plan<T> plan;
+	(options.apply(plan), ...);
+	internals::build_into(xlsx_file_name, sheet_name, T::_info_.file_name, plan);
+}
+// The workbook, or the CSV or TSV file, held in memory, whose name gives the format.
+template<typename T, typename... Options>
+void
+build(fd_read_xlsx::Buffer const& buffer,
+      char const* const name,
+      char const* const sheet_name = "",
+      Options const&... options)
+{
+	Plan<T> plan;
+	(options.apply(plan), ...);
+	internals::build_into(name, sheet_name, T::_info_.file_name, plan, &buffer);
+}
+
+// The files matching a shell pattern, sorted: build_dataset<Row>(get_files("data/*.xlsx")).
+std::vector<str_t>
+get_files(str_t const& pattern)
+{
+	glob_t files;
+	auto const ret{ ::glob(pattern.c_str(), 0, nullptr, &files) };
+	if ((ret != 0) && (ret != GLOB_NOMATCH)) {
+		globfree(&files);
+		throw Exception{ "unable to expand the “" + pattern + "” pattern" };
+	}
+	std::vector<str_t> rvo;
+	for (size_t k{ 0 }; (ret == 0) && (k < files.gl_pathc); ++k)
+		rvo.push_back(files.gl_pathv[k]);
+	globfree(&files);
+	return rvo;
+}
+
+// A dataset is made of partitions with the same struct, one by workbook (for instance one by
+// month): each partition is a directory of chunks, named after the base name of its workbook, in
+// the directory of the dataset. The “partitions” file of the dataset lists them, one by line.
+//   build_dataset<Row>(get_files("sales-*.xlsx"), "", sort_by(&Row::date));
+//   auto const all{ read_dataset<Row>() };
+//   auto const q1{ read_dataset<Row>("", { "sales-01", "sales-02", "sales-03" }) };
+// The workbooks are built concurrently, with the options given; the statistics of each build are
+// given to the callback of set_stats, which may then be called concurrently.
+template<typename T, typename... Options>
+void
+build_dataset(std::vector<str_t> const& file_names,
+              char const* const sheet_name = "",
+              Options const&... options)
+{
+	Plan<T> plan;
+	(options.apply(plan), ...);
+	std::vector<str_t> names;
+	for (auto const& file_name : file_names) {
+		names.push_back(get_base_name(file_name.c_str()));
+		if (std::find(cbegin(names), cend(names) - 1, names.back()) != cend(names) - 1)
+			throw Exception{ "two workbooks of the dataset have the “" + names.back() + "” base name" };
+	}
+	str_t const dir{ T::_info_.file_name };
+	pool().run(file_names.size(), [&](size_t k) {
+		internals::build_into(file_names[k].c_str(), sheet_name, dir + '/' + names[k], plan);
+	});
+	// The list is written in a temporary file, then replaces the previous one at once.
+	auto const name{ dir + "/partitions.tmp" };
+	std::filesystem::create_directories(dir);
+	std::ofstream out{ name };
+	if (!out.is_open())
+		throw Exception{ "unable to open for output the “" + name + "” file" };
+	for (auto const& partition : names)
+		out << partition << '\n';
+	if (!out)
+		throw Exception{ "unable to write the “" + name + "” file" };
+	out.close();
+	std::filesystem::rename(name, dir + "/partitions");
+}
+template<typename T>
+void
+task_read(str_t const& file_name, T* const rows, size_t nr_rows)
+{
+	if (nr_rows == 0)
+		return;
+	auto in{ gzopen(file_name.c_str(), "rb") };
+	if (in == NULL)
+		throw Exception{ "unable to open for input the “" + file_name + "” file" };
+	size_t const n = gzread(in, reinterpret_cast<char*>(rows), nr_rows * sizeof(T));
+	auto const ret{ gzclose(in) };
+	if (n != nr_rows * sizeof(T))
+		throw Exception{ "unable to read the zipped stream from the “" + file_name + "” file" };
+	if (ret != Z_OK)
+		throw Exception{ "unable to close the “" + file_name + "” file" };
+}
+// Read the chunks one after the other from rows.
+template<typename T>
+void
+read_chunks(str_t const& dir,
+            std::vector<Chunk<T>> const& chunks,
+            T* const rows,
+            internals::Recorder* const recorder = nullptr)
+{
+	std::vector<size_t> starts;
+	starts.reserve(chunks.size());
+	size_t n{ 0 };
+	for (auto const& chunk : chunks)
+		starts.push_back(n), n += chunk.n;
+	pool().run(chunks.size(), [&](size_t k) {
+		auto const name{ get_chunk_name(dir, chunks[k]) };
+		if (recorder)
+			recorder->time_chunk([&]() { task_read<T>(name, rows + starts[k], chunks[k].n); }, name);
+		else
+			task_read<T>(name, rows + starts[k], chunks[k].n);
+	});
+}
+
+// An allocator for the tables read: read<Row, Table_allocator<Row>>(dir_name).
+// The rows are default-initialized, so their pages are first touched by the thread of the pool
+// which inflates their chunk, and are placed by the kernel on the NUMA node of this thread. The
+// tables of at least a huge page are mapped on huge page boundaries and advised to use transparent
+// huge pages, where the kernel has them. The placement is approximate: the chunks are not aligned
+// on the pages, so a page shared by two chunks, and a huge page holding several chunks, goes to the
+// node of the first thread which touches it.
+constexpr size_t huge_page_size{ size_t(1) << 21 };
+
+template<typename T>
+struct Table_allocator
+{
+	typedef T value_type;
+	Table_allocator() = default;
+	template<typename U>
+	Table_allocator(Table_allocator<U> const&)
+	{}
+	T* allocate(size_t n)
+	{
+		auto const size{ n * sizeof(T) };
+		if (size < huge_page_size)
+			return static_cast<T*>(::operator new(size));
+		// Map a huge page more, then unmap the bytes before and after the aligned range.
+		auto const rounded{ get_rounded(size) };
+		auto const ptr{ mmap(nullptr,
+		                     rounded + huge_page_size,
+		                     PROT_READ | PROT_WRITE,
+		                     MAP_PRIVATE | MAP_ANONYMOUS,
+		                     -1,
+		                     0) };
+		if (ptr == MAP_FAILED)
+			throw std::bad_alloc{};
+		auto const first{ reinterpret_cast<uintptr_t>(ptr) };
+		auto const aligned{ (first + huge_page_size - 1) / huge_page_size * huge_page_size };
+		if (aligned > first)
+			munmap(ptr, aligned - first);
+		if (first + huge_page_size > aligned)
+			munmap(reinterpret_cast<void*>(aligned + rounded), first + huge_page_size - aligned);
+#ifdef MADV_HUGEPAGE
+		// Not an error if the kernel has no transparent huge pages.
+		madvise(reinterpret_cast<void*>(aligned), rounded, MADV_HUGEPAGE);
+#endif
+		return reinterpret_cast<T*>(aligned);
+	}
+	void deallocate(T* ptr, size_t n)
+	{
+		auto const size{ n * sizeof(T) };
+		if (size < huge_page_size)
+			::operator delete(ptr);
+		else
+			munmap(ptr, get_rounded(size));
+	}
+	// No value initialization.
+	template<typename U, typename... Args>
+	void construct(U* ptr, Args&&... args)
+	{
+		if constexpr (sizeof...(Args) == 0)
+			::new (static_cast<void*>(ptr)) U;
+		else
+			::new (static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+	}
+	static size_t get_rounded(size_t size)
+	{
+		return (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+	}
+};
+template<typename T, typename U>
+bool
+operator==(Table_allocator<T> const&, Table_allocator<U> const&)
+{
+	return true;
+}
+template<typename T, typename U>
+bool
+operator!=(Table_allocator<T> const&, Table_allocator<U> const&)
+{
+	return false;
+}
+
+template<typename T, typename A = std::allocator<T>>
+std::vector<T, A>
+read_chunks(str_t const& dir,
+            std::vector<Chunk<T>> const& chunks,
+            internals::Recorder* const recorder = nullptr)
+{
+	size_t n{ 0 };
+	for (auto const& chunk : chunks)
+		n += chunk.n;
+	std::vector<T, A> rvo(n);
+	if (recorder)
+		recorder->hold("rows", n * sizeof(T));
+	read_chunks(dir, chunks, rvo.data(), recorder);
+	if (recorder)
+		recorder->add_rows(n, sizeof(T));
+	return rvo;
+}
+template<typename T, typename A = std::allocator<T>>
+std::vector<T, A>
+read(str_t const& dir_name = "")
+{
+	auto const dir{ get_dir<T>(dir_name) };
+	internals::Recorder recorder{ "read", dir };
+	auto const manifest{ read_manifest<T>(dir) };
+	recorder.end_phase("manifest");
+	auto rvo{ read_chunks<T, A>(dir, manifest.chunks, &recorder) };
+	recorder.end_phase("unzip");
+	recorder.finish();
+	return rvo;
+}
+
+// sorted_by<Row>(dir_name, &Row::date) is true if the chunks were built with sort keys starting
+// with the given data members: the table returned by read<Row>(dir_name) is then sorted by them.
+template<typename T, typename... Us>
+bool
+sorted_by(str_t const& dir_name, Us T::*... m_ptrs)
+{
+	auto const manifest{ read_manifest<T>(get_dir<T>(dir_name)) };
+	std::vector<uint64_t> const keys{ get_column(m_ptrs)... };
+	return (keys.size() <= manifest.keys.size()) &&
+	       std::equal(cbegin(keys), cend(keys), cbegin(manifest.keys));
+}
+
+// Predicates for read<T>(predicate, dir_name): the chunks whose zone map cannot match the predicate
+// are neither read nor inflated, then the rows of the read chunks are filtered.
+//   read<Row>(between(&Row::date, 20200101, 20201231) && equal(&Row::region, "north"))
+// A missing value never matches.
+struct Predicate
+{};
+template<typename P>
+constexpr bool is_predicate{ std::is_base_of_v<Predicate, P> };
+
+// The key of a predicate on a string data member can be given as a string.
+template<typename U>
+struct Key
+{
+	static U get(U const& u) { return u; }
+};
+template<size_t N>
+struct Key<std::array<char, N>>
+{
+	static std::array<char, N> get(std::array<char, N> const& a) { return a; }
+	static std::array<char, N> get(str_t const& str)
+	{
+		if (str.size() > N)
+			throw Exception{ "the key “" + str + "” is longer than " + std::to_string(N) + " chars" };
+		std::array<char, N> rvo;
+		rvo.fill('\0');
+		std::copy(cbegin(str), cend(str), begin(rvo));
+		return rvo;
+	}
+};
+
+template<typename T, typename U>
+struct Between : Predicate
+{
+	U T::*m_ptr;
+	U lo;
+	U hi;
+	bool operator()(T const& row) const
+	{
+		auto const& u{ row.*m_ptr };
+		return !missing(u) && !less(u, lo) && !less(hi, u);
+	}
+	bool may_match(Chunk<T> const& chunk) const
+	{
+		auto const& min{ chunk.min.*m_ptr };
+		return !missing(min) && !less(hi, min) && !less(chunk.max.*m_ptr, lo);
+	}
+};
+template<typename P, typename Q>
+struct And : Predicate
+{
+	P p;
+	Q q;
+	template<typename T>
+	bool operator()(T const& row) const
+	{
+		return p(row) && q(row);
+	}
+	template<typename T>
+	bool may_match(Chunk<T> const& chunk) const
+	{
+		return p.may_match(chunk) && q.may_match(chunk);
+	}
+};
+template<typename P, typename Q>
+struct Or : Predicate
+{
+	P p;
+	Q q;
+	template<typename T>
+	bool operator()(T const& row) const
+	{
+		return p(row) || q(row);
+	}
+	template<typename T>
+	bool may_match(Chunk<T> const& chunk) const
+	{
+		return p.may_match(chunk) || q.may_match(chunk);
+	}
+};
+template<typename T, typename U, typename K, typename L>
+Between<T, U>
+between(U T::*m_ptr, K const& lo, L const& hi)
+{
+	return { {}, m_ptr, Key<U>::get(lo), Key<U>::get(hi) };
+}
+template<typename T, typename U, typename K>
+Between<T, U>
+equal(U T::*m_ptr, K const& key)
+{
+	return between(m_ptr, key, key);
+}
+template<typename P, typename Q, typename = std::enable_if_t<is_predicate<P> && is_predicate<Q>>>
+And<P, Q>
+operator&&(P const& p, Q const& q)
+{
+	return { {}, p, q };
+}
+template<typename P, typename Q, typename = std::enable_if_t<is_predicate<P> && is_predicate<Q>>>
+Or<P, Q>
+operator||(P const& p, Q const& q)
+{
+	return { {}, p, q };
+}
+template<typename T, typename P, typename = std::enable_if_t<is_predicate<P>>>
+std::vector<T>
+read(P const& pred, str_t const& dir_name = "")
+{
+	auto const dir{ get_dir<T>(dir_name) };
+	internals::Recorder recorder{ "read", dir };
+	auto const manifest{ read_manifest<T>(dir) };
+	std::vector<Chunk<T>> chunks;
+	for (auto const& chunk : manifest.chunks)
+		if (pred.may_match(chunk))
+			chunks.push_back(chunk);
+	recorder.end_phase("manifest");
+	auto rvo{ read_chunks<T>(dir, chunks, &recorder) };
+	recorder.end_phase("unzip");
+	rvo.erase(std::remove_if(begin(rvo), end(rvo), [&](T const& row) { return !pred(row); }),
+	          end(rvo));
+	recorder.end_phase("filter");
+	recorder.finish();
+	return rvo;
+}
+
+// The partitions of the dataset built by build_dataset<T>, in the order of its workbooks.
+template<typename T>
+std::vector<str_t>
+get_partitions(str_t const& dir_name = "")
+{
+	auto const name{ get_dir<T>(dir_name) + "/partitions" };
+	std::ifstream in{ name };
+	if (!in.is_open())
+		throw Exception{ "unable to open for input the “" + name + "” file (dataset not built?)" };
+	std::vector<str_t> rvo;
+	for (str_t partition; std::getline(in, partition);)
+		rvo.push_back(partition);
+	return rvo;
+}
+namespace internals {
+// Read the kept chunks of the partitions, all of them if none is given, into one table: the
+// chunks of all the partitions are read concurrently.
+template<typename T, typename Keep>
+std::vector<T>
+read_partitions(str_t const& dir_name,
+                std::vector<str_t> const& partitions,
+                Keep const& keep,
+                Recorder& recorder)
+{
+	auto const all{ get_partitions<T>(dir_name) };
+	for (auto const& partition : partitions)
+		if (std::find(cbegin(all), cend(all), partition) == cend(all))
+			throw Exception{ "the “" + partition + "” partition is not in the dataset" };
+	auto const& names{ partitions.empty() ? all : partitions };
+	auto const dir{ get_dir<T>(dir_name) };
+	std::vector<Manifest<T>> manifests(names.size());
+	pool().run(names.size(),
+	           [&](size_t k) { manifests[k] = read_manifest<T>(dir + '/' + names[k]); });
+	// The partition, the chunk and the first row of each chunk to read.
+	std::vector<std::tuple<size_t, Chunk<T> const*, size_t>> tasks;
+	size_t n{ 0 };
+	for (size_t k{ 0 }; k < manifests.size(); ++k)
+		for (auto const& chunk : manifests[k].chunks)
+			if (keep(chunk))
+				tasks.emplace_back(k, &chunk, n), n += chunk.n;
+	recorder.end_phase("manifest");
+	std::vector<T> rvo(n);
+	recorder.hold("rows", n * sizeof(T));
+	pool().run(tasks.size(), [&](size_t t) {
+		auto const [k, chunk, start]{ tasks[t] };
+		auto const name{ get_chunk_name(dir + '/' + names[k], *chunk) };
+		recorder.time_chunk([&]() { task_read<T>(name, rvo.data() + start, chunk->n); }, name);
+	});
+	recorder.add_rows(n, sizeof(T));
+	recorder.end_phase("unzip");
+	return rvo;
+}
+} // namespace internals
+// The rows of the partitions given, or of all of them, one partition after the other.
+template<typename T>
+std::vector<T>
+read_dataset(str_t const& dir_name = "", std::vector<str_t> const& partitions = {})
+{
+	internals::Recorder recorder{ "read", get_dir<T>(dir_name) };
+	auto rvo{ internals::read_partitions<T>(
+	  dir_name, partitions, [](Chunk<T> const&) { return true; }, recorder) };
+	recorder.finish();
+	return rvo;
+}
+template<typename T, typename P, typename = std::enable_if_t<is_predicate<P>>>
+std::vector<T>
+read_dataset(P const& pred, str_t const& dir_name = "", std::vector<str_t> const& partitions = {})
+{
+	internals::Recorder recorder{ "read", get_dir<T>(dir_name) };
+	auto rvo{ internals::read_partitions<T>(
+	  dir_name, partitions, [&](Chunk<T> const& chunk) { return pred.may_match(chunk); }, recorder) };
+	rvo.erase(std::remove_if(begin(rvo), end(rvo), [&](T const& row) { return !pred(row); }),
+	          end(rvo));
+	recorder.end_phase("filter");
+	recorder.finish();
+	return rvo;
+}
+// A contiguous range of values, like the rows of a key in an Index.
+template<typename V>
+struct Span
+{
+	V const* first;
+	V const* last;
+	V const* data() const { return first; }
+	V const* begin() const { return first; }
+	V const* end() const { return last; }
+	size_t size() const { return last - first; }
+	bool empty() const { return first == last; }
+	V const& operator[](size_t i) const { return first[i]; }
+};
+
+// Read the chunks one after the other, while the next ones are inflated by the pool:
+//   Stream<Row> stream{ dir_name, 4 };
+//   while (auto const batch{ stream.next() })
+//     for (auto const& row : *batch)
+//       ...
+// A batch holds the rows of a chunk and is valid until the next call of next(). At most
+// nr_in_flight chunks are in memory, each one in its own buffer: the buffer of a batch is reused
+// for the chunk read nr_in_flight chunks later.
+template<typename T>
+class Stream
+{
+public:
+	Stream(str_t const& dir_name = "", size_t nr_in_flight = 4)
+	  : dir_(get_dir<T>(dir_name))
+	  , manifest_(read_manifest<T>(dir_))
+	  , buffers_(std::max(size_t(1), nr_in_flight))
+	  , futures_(buffers_.size())
+	{
+		for (size_t id{ 0 }; id < std::min(buffers_.size(), manifest_.chunks.size()); ++id)
+			prefetch(id);
+	}
+	Stream(Stream const&) = delete;
+	Stream& operator=(Stream const&) = delete;
+	// The tasks write in the buffers: wait for them.
+	~Stream()
+	{
+		for (auto const& future : futures_)
+			if (future.valid())
+				pool().wait(future);
+	}
+	// The number of rows of all the chunks.
+	size_t size() const { return manifest_.n; }
+	// The rows of the next chunk, none after the last one. An error of the inflation of the chunk is
+	// thrown here: the chunk is skipped, and the next call returns the following one.
+	std::optional<Span<T>> next()
+	{
+		auto const& chunks{ manifest_.chunks };
+		// The buffer of the previous batch is free.
+		if ((next_ > 0) && (next_ - 1 + buffers_.size() < chunks.size()))
+			prefetch(next_ - 1 + buffers_.size());
+		if (next_ == chunks.size())
+			return {};
+		auto const slot{ next_ % buffers_.size() };
+		pool().wait(futures_[slot]);
+		// Before get, which throws the error of the task.
+		++next_;
+		futures_[slot].get();
+		auto const& buffer{ buffers_[slot] };
+		return Span<T>{ buffer.data(), buffer.data() + buffer.size() };
+	}
+
+private:
+	void prefetch(size_t id)
+	{
+		auto& buffer{ buffers_[id % buffers_.size()] };
+		buffer.resize(manifest_.chunks[id].n);
+		futures_[id % buffers_.size()] = pool().post([this, id, &buffer]() {
+			task_read<T>(get_chunk_name(dir_, manifest_.chunks[id]), buffer.data(), buffer.size());
+		});
+	}
+
+	str_t const dir_;
+	Manifest<T> const manifest_;
+	std::vector<std::vector<T>> buffers_;
+	std::vector<std::future<void>> futures_;
+	size_t next_{ 0 };
+};
+
+// Lexicographic order of the keys: the keys are compared on the elements of the shortest one, so a
+// key can be compared to a prefix.
+template<size_t I = 0, typename A, typename B>
+int
+compare(A const& a, B const& b)
+{
+	if constexpr ((I == std::tuple_size_v<A>) || (I == std::tuple_size_v<B>))
+		return 0;
+	else {
+		if (less(std::get<I>(a), std::get<I>(b)))
+			return -1;
+		if (less(std::get<I>(b), std::get<I>(a)))
+			return 1;
+		return compare<I + 1>(a, b);
+	}
+}
+template<typename... Us>
+bool
+less(std::tuple<Us...> const& a, std::tuple<Us...> const& b)
+{
+	return compare(a, b) < 0;
+}
+template<typename... Us>
+str_t
+to_string(std::tuple<Us...> const& key)
+{
+	return std::apply(
+	  [](auto const&... u) {
+		  str_t rvo;
+		  ((rvo += (rvo.empty() ? "" : ", ") + std::to_string(u)), ...);
+		  return rvo;
+	  },
+	  key);
+}
+
+// Index<Row, U, V> const idx{ table, &Row::member_u, &Row::member_v };
+// idx.equal_range(u, v)   all the rows of the key (u, v)
+// idx.equal_range(u)      all the rows whose key starts with u
+// idx.range(lo, hi)       all the rows whose key is between lo and hi (a value or a tuple of values)
+// The index is a flat array by member of the key, sorted by the pool, and the array of the matching
+// rows: the rows of a key, or of a range of keys, are contiguous and sorted by key then by row. It
+// does not refer to the table: it is valid as long as the table is not changed, and the lookups are
+// safe from several threads. The table is a std::vector<Row> or a Shared_table<Row>.
+// The index can be saved in a file, then mapped without any relocation: a header, the array of each
+// member of the key, then the rows, each one aligned on 64 bytes. The arrays have no padding and do
+// not depend on the layout of std::tuple. The hash of the table, computed from the hashes of the
+// chunks, rejects an index built on another table.
+struct Index_header
+{
+	char magic[8];
+	uint64_t layout;
+	// The sum of the sizes of the members of the key.
+	uint64_t key_size;
+	uint64_t nr_keys;
+	uint64_t table_hash;
+	uint64_t n;
+	uint64_t keys_offset;
+	uint64_t rows_offset;
+	uint64_t file_size;
+};
+
+constexpr char index_magic[8]{ 'x', 'l', 's', 'x', '2', 't', 'i', '2' };
+
+template<typename T, typename... Us>
+class Index
+{
+public:
+	using key_type = std::tuple<Us...>;
+	static constexpr size_t npos{ std::numeric_limits<size_t>::max() };
+	template<typename Table>
+	Index(Table const& table, Us T::*... m_ptrs)
+	{
+		auto const rows{ table.data() };
+		std::vector<std::pair<key_type, size_t>> pairs(table.size());
+		for_each_block(pairs.size(), [&](size_t start, size_t end) {
+			for (auto i{ start }; i < end; ++i)
+				pairs[i] = { key_type{ rows[i].*m_ptrs... }, i };
+		});
+		parallel_sort(pairs, [](auto const& p, auto const& q) {
+			auto const cmp{ compare(p.first, q.first) };
+			return (cmp < 0) || ((cmp == 0) && (p.second < q.second));
+		});
+		n_ = pairs.size();
+		std::apply([&](auto&... columns) { (columns.resize(n_), ...); }, key_vectors_);
+		row_vector_.resize(n_);
+		for_each_block(n_, [&](size_t start, size_t end) {
+			for (auto i{ start }; i < end; ++i)
+				set_key(i, pairs[i].first, ids_type{}), row_vector_[i] = pairs[i].second;
+		});
+		keys_ = std::apply([](auto const&... columns) { return std::make_tuple(columns.data()...); },
+		                   key_vectors_);
+		rows_ = row_vector_.data();
+	}
+	// The keys and the rows point to the vectors: an index is moved, not copied.
+	Index(Index&&) = default;
+	Index(Index const&) = delete;
+	Index& operator=(Index const&) = delete;
+	// An index within a mapping of a file or of a shared memory segment.
+	Index(std::shared_ptr<Mapping const> mapping,
+	      char const* const ptr,
+	      size_t size,
+	      uint64_t table_hash,
+	      str_t const& name)
+	  : mapping_{ std::move(mapping) }
+	{
+		if (size < sizeof(Index_header))
+			throw Exception{ "“" + name + "” is not an index (file corrupted?)" };
+		auto const& header{ *reinterpret_cast<Index_header const*>(ptr) };
+		if ((std::memcmp(header.magic, index_magic, sizeof(header.magic)) != 0) ||
+		    (header.file_size != size))
+			throw Exception{ "“" + name + "” is not an index (file corrupted?)" };
+		if ((header.layout != T::_info_.layout) || (header.key_size != key_size) ||
+		    (header.nr_keys != sizeof...(Us)))
+			throw Exception{ "the index “" + name + "” was not built with the current “" +
+				               T::_info_.struct_name + "” struct (chunks not rebuilt?)" };
+		if (header.table_hash != table_hash)
+			throw Exception{ "the index “" + name + "” was not built with the current chunks" };
+		// The offsets are computed from n, which is bounded first so they do not overflow.
+		auto const offsets{ get_offsets(std::min(header.n, size / sizeof(size_t))) };
+		if ((header.n > size / sizeof(size_t)) || (header.keys_offset != offsets[0]) ||
+		    (header.rows_offset != offsets[sizeof...(Us)]) ||
+		    (offsets[sizeof...(Us) + 1] != size))
+			throw Exception{ "“" + name + "” is not an index (file corrupted?)" };
+		n_ = header.n;
+		set_keys(ptr, offsets, ids_type{});
+		rows_ = reinterpret_cast<size_t const*>(ptr + header.rows_offset);
+	}
+	static Index load(str_t const& file_name, uint64_t table_hash)
+	{
+		auto mapping{ map_file(file_name) };
+		auto const ptr{ static_cast<char const*>(mapping->ptr_) };
+		auto const size{ mapping->size_ };
+		return Index{ std::move(mapping), ptr, size, table_hash, file_name };
+	}
+	// Written in a temporary file, then renamed: a mapping of the previous file stays valid.
+	void save(str_t const& file_name, uint64_t table_hash) const
+	{
+		auto const offsets{ get_offsets(n_) };
+		Index_header header{ {},
+			                   T::_info_.layout,
+			                   key_size,
+			                   sizeof...(Us),
+			                   table_hash,
+			                   n_,
+			                   offsets[0],
+			                   offsets[sizeof...(Us)],
+			                   offsets[sizeof...(Us) + 1] };
+		std::memcpy(header.magic, index_magic, sizeof(header.magic));
+		auto const name{ file_name + ".tmp" };
+		{
+			std::ofstream out{ name, std::ios::binary };
+			if (!out.is_open())
+				throw Exception{ "unable to open for output the “" + name + "” file" };
+			str_t const padding(64, '\0');
+			size_t offset{ 0 };
+			auto const write{ [&](void const* data, size_t start, size_t size) {
+				out.write(padding.data(), start - offset);
+				out.write(static_cast<char const*>(data), size);
+				offset = start + size;
+			} };
+			write(&header, 0, sizeof(header));
+			std::apply(
+			  [&](auto const*... columns) {
+				  size_t j{ 0 };
+				  ((write(columns, offsets[j], n_ * sizeof(*columns)), ++j), ...);
+			  },
+			  keys_);
+			write(rows_, offsets[sizeof...(Us)], n_ * sizeof(size_t));
+			if (!out)
+				throw Exception{ "unable to write the “" + name + "” file" };
+		}
+		std::filesystem::rename(name, file_name);
+	}
+	size_t size() const { return n_; }
+	// The position of the first key not less than the key (or the prefix), and of the first key
+	// greater than it.
+	template<typename K>
+	size_t lower_bound(K const& k) const
+	{
+		auto const key{ get_key(k) };
+		return partition_point([&](key_type const& u) { return compare(u, key) < 0; });
+	}
+	template<typename K>
+	size_t upper_bound(K const& k) const
+	{
+		auto const key{ get_key(k) };
+		return partition_point([&](key_type const& u) { return compare(u, key) <= 0; });
+	}
+	// The rows between two positions.
+	Span<size_t> rows(size_t first, size_t last) const
+	{
+		return { rows_ + first, rows_ + last };
+	}
+	template<typename... Ks>
+	Span<size_t> equal_range(Ks const&... ks) const
+	{
+		auto const key{ std::make_tuple(ks...) };
+		return rows(lower_bound(key), upper_bound(key));
+	}
+	template<typename K, typename L>
+	Span<size_t> range(K const& lo, L const& hi) const
+	{
+		auto const first{ lower_bound(lo) };
+		return rows(first, std::max(first, upper_bound(hi)));
+	}
+	// The first row of the key, or npos.
+	template<typename... Ks>
+	size_t find(Ks const&... ks) const
+	{
+		auto const span{ equal_range(ks...) };
+		return span.empty() ? npos : span[0];
+	}
+	// The first row of the key, or an exception.
+	template<typename... Ks>
+	size_t at(Ks const&... ks) const
+	{
+		auto const row{ find(ks...) };
+		if (row == npos)
+			throw Exception{ "key “" + to_string(get_key(std::make_tuple(ks...))) + "“ not found" };
+		return row;
+	}
+
+private:
+	// A key, or a prefix of a key, is given as a value or as a tuple of values.
+	template<typename K>
+	static auto get_key(K const& k)
+	{
+		return get_key(std::make_tuple(k));
+	}
+	template<typename... Ks>
+	static auto get_key(std::tuple<Ks...> const& k)
+	{
+		static_assert(sizeof...(Ks) <= sizeof...(Us), "the key has too many values");
+		return get_key(k, std::index_sequence_for<Ks...>{});
+	}
+	template<typename K, size_t... Is>
+	static auto get_key(K const& k, std::index_sequence<Is...>)
+	{
+		return std::make_tuple(Key<std::tuple_element_t<Is, key_type>>::get(std::get<Is>(k))...);
+	}
+
+	using ids_type = std::index_sequence_for<Us...>;
+	static constexpr size_t key_size{ (sizeof(Us) + ...) };
+	// The offsets of the arrays of the members of the key, of the rows, and the size of the file.
+	static std::array<size_t, sizeof...(Us) + 2> get_offsets(size_t n)
+	{
+		auto const align{ [](size_t offset) { return (offset + 63) / 64 * 64; } };
+		std::array<size_t, sizeof...(Us) + 2> rvo;
+		rvo[0] = align(sizeof(Index_header));
+		size_t j{ 0 };
+		((++j, rvo[j] = align(rvo[j - 1] + n * sizeof(Us))), ...);
+		rvo[j + 1] = rvo[j] + n * sizeof(size_t);
+		return rvo;
+	}
+	template<size_t... Is>
+	key_type get_key_at(size_t i, std::index_sequence<Is...>) const
+	{
+		return { std::get<Is>(keys_)[i]... };
+	}
+	template<size_t... Is>
+	void set_key(size_t i, key_type const& key, std::index_sequence<Is...>)
+	{
+		((std::get<Is>(key_vectors_)[i] = std::get<Is>(key)), ...);
+	}
+	template<typename Offsets, size_t... Is>
+	void set_keys(char const* ptr, Offsets const& offsets, std::index_sequence<Is...>)
+	{
+		keys_ = { reinterpret_cast<Us const*>(ptr + offsets[Is])... };
+	}
+	// The first position whose key is not true for f, as std::partition_point.
+	template<typename F>
+	size_t partition_point(F const& f) const
+	{
+		size_t first{ 0 };
+		for (auto count{ n_ }; count > 0;) {
+			auto const step{ count / 2 };
+			if (f(get_key_at(first + step, ids_type{})))
+				first += step + 1, count -= step + 1;
+			else
+				count = step;
+		}
+		return first;
+	}
+
+	std::tuple<Us const*...> keys_;
+	size_t const* rows_{ nullptr };
+	size_t n_{ 0 };
+	// The storage of the keys and of the rows: the vectors or a mapping.
+	std::tuple<std::vector<Us>...> key_vectors_;
+	std::vector<size_t> row_vector_;
+	std::shared_ptr<Mapping const> mapping_;
+};
+
+// load_index<Row>(dir_name, &Row::date, &Row::id) maps the index built by
+// build<Row>(xlsx_file_name, sheet_name, index_on(&Row::date, &Row::id)).
+template<typename T, typename... Us>
+Index<T, Us...>
+load_index(str_t const& dir_name, Us T::*... m_ptrs)
+{
+	auto const dir{ get_dir<T>(dir_name) };
+	return Index<T, Us...>::load(dir + '/' + get_index_name({ get_column(m_ptrs)... }),
+	                             get_table_hash(read_manifest<T>(dir)));
+}
+// A table is published in a POSIX shared memory segment by publish<Row>(segment_name, dir_name) and
+// the other processes attach to it read-only by attach<Row>(segment_name). The segment is made of a
+// header, the sort keys, the chunks of the manifest, the list of the indexes, the rows, aligned on a
+// page, then the indexes saved by build<Row>, aligned on 64 bytes. The magic is written last: a
+// segment is not attached while it is published. The layout of the struct is checked at attach
+// time.
+struct Segment_header
+{
+	char magic[8];
+	uint64_t layout;
+	uint64_t size;
+	uint64_t n;
+	uint64_t nr_keys;
+	uint64_t nr_chunks;
+	uint64_t nr_indexes;
+	uint64_t rows_offset;
+	uint64_t segment_size;
+};
+
+struct Segment_index
+{
+	char name[48];
+	uint64_t offset;
+	uint64_t size;
+};
+
+constexpr char segment_magic[8]{ 'x', 'l', 's', 'x', '2', 't', 's', '1' };
+
+str_t
+get_segment_name(str_t const& segment_name)
+{
+	return (!segment_name.empty() && (segment_name[0] == '/')) ? segment_name : ('/' + segment_name);
+}
+template<typename T>
+void
+publish(str_t const& segment_name, str_t const& dir_name = "")
+{
+	auto const dir{ get_dir<T>(dir_name) };
+	auto const manifest{ read_manifest<T>(dir) };
+	auto const name{ get_segment_name(segment_name) };
+	auto const page{ size_t(sysconf(_SC_PAGESIZE)) };
+	auto const paths{ get_index_paths(dir) };
+	auto const meta_size{ sizeof(Segment_header) + manifest.keys.size() * sizeof(uint64_t) +
+		                    manifest.chunks.size() * sizeof(Chunk<T>) +
+		                    paths.size() * sizeof(Segment_index) };
+	auto const rows_offset{ (meta_size + page - 1) / page * page };
+	std::vector<Segment_index> indexes(paths.size());
+	auto segment_size{ rows_offset + manifest.n * sizeof(T) };
+	for (size_t k{ 0 }; k < paths.size(); ++k) {
+		auto const name{ paths[k].filename().string() };
+		if (name.size() >= sizeof(indexes[k].name))
+			throw Exception{ "the name of the “" + paths[k].string() + "” index is too long" };
+		std::memset(indexes[k].name, 0, sizeof(indexes[k].name));
+		std::memcpy(indexes[k].name, name.data(), name.size());
+		indexes[k].offset = (segment_size + 63) / 64 * 64;
+		indexes[k].size = std::filesystem::file_size(paths[k]);
+		segment_size = indexes[k].offset + indexes[k].size;
+	}
+
+	// A previous segment is unlinked: the processes which are attached to it keep their view.
+	shm_unlink(name.c_str());
+	auto const fd{ shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644) };
+	if (fd < 0)
+		throw Exception{ "unable to create the “" + name + "” shared memory segment (" +
+			               std::strerror(errno) + ')' };
+	if (ftruncate(fd, segment_size) != 0) {
+		auto const error{ errno };
+		close(fd);
+		shm_unlink(name.c_str());
+		throw Exception{ "unable to size the “" + name + "” shared memory segment (" +
+			               std::strerror(error) + ')' };
+	}
+	Mapping const mapping{ mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0),
+		                     segment_size };
+	close(fd);
+	if (mapping.ptr_ == MAP_FAILED) {
+		shm_unlink(name.c_str());
+		throw Exception{ "unable to map the “" + name + "” shared memory segment" };
+	}
+	auto const base{ static_cast<char*>(mapping.ptr_) };
+	auto const header{ reinterpret_cast<Segment_header*>(base) };
+	*header = Segment_header{ {},
+		                        T::_info_.layout,
+		                        sizeof(T),
+		                        manifest.n,
+		                        manifest.keys.size(),
+		                        manifest.chunks.size(),
+		                        indexes.size(),
+		                        rows_offset,
+		                        segment_size };
+	auto ptr{ base + sizeof(Segment_header) };
+	std::memcpy(ptr, manifest.keys.data(), manifest.keys.size() * sizeof(uint64_t));
+	ptr += manifest.keys.size() * sizeof(uint64_t);
+	std::memcpy(ptr, manifest.chunks.data(), manifest.chunks.size() * sizeof(Chunk<T>));
+	ptr += manifest.chunks.size() * sizeof(Chunk<T>);
+	std::memcpy(ptr, indexes.data(), indexes.size() * sizeof(Segment_index));
+	try {
+		read_chunks(dir, manifest.chunks, reinterpret_cast<T*>(base + rows_offset));
+		for (size_t k{ 0 }; k < paths.size(); ++k) {
+			std::ifstream in{ paths[k], std::ios::binary };
+			if (!in.read(base + indexes[k].offset, indexes[k].size))
+				throw Exception{ "unable to read the “" + paths[k].string() + "” file" };
+		}
+	} catch (...) {
+		shm_unlink(name.c_str());
+		throw;
+	}
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(header->magic, segment_magic, sizeof(header->magic));
+}
+// Remove the name of the segment; the attached processes keep their view.
+void
+unpublish(str_t const& segment_name)
+{
+	shm_unlink(get_segment_name(segment_name).c_str());
+}
+
+// Read-only view on a published table.
+template<typename T>
+class Shared_table
+{
+public:
+	Shared_table(str_t const& segment_name)
+	  : mapping_{ map(get_segment_name(segment_name)) }
+	{
+		auto const base{ static_cast<char const*>(mapping_->ptr_) };
+		auto const size{ mapping_->size_ };
+		auto const name{ get_segment_name(segment_name) };
+		if (size < sizeof(Segment_header))
+			throw Exception{ "the “" + name + "” shared memory segment is not a published table" };
+		auto const& header{ *reinterpret_cast<Segment_header const*>(base) };
+		if (std::memcmp(header.magic, segment_magic, sizeof(header.magic)) != 0)
+			throw Exception{ "the “" + name + "” shared memory segment is not a published table" };
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if ((header.layout != T::_info_.layout) || (header.size != sizeof(T)))
+			throw Exception{ "the table in the “" + name +
+				               "” shared memory segment was not published with the current “" +
+				               T::_info_.struct_name + "” struct (table not published again?)" };
+		if (header.segment_size != size)
+			throw Exception{ "the size of the “" + name + "” shared memory segment is invalid" };
+		// The numbers are bounded first, so the sizes computed from them do not overflow.
+		auto const corrupted{ Exception{ "the “" + name + "” shared memory segment is corrupted" } };
+		if ((header.nr_keys > size / sizeof(uint64_t)) ||
+		    (header.nr_chunks > size / sizeof(Chunk<T>)) ||
+		    (header.nr_indexes > size / sizeof(Segment_index)) || (header.n > size / sizeof(T)) ||
+		    (header.rows_offset > size) || (header.rows_offset % alignof(T) != 0))
+			throw corrupted;
+		auto const meta_size{ sizeof(Segment_header) + header.nr_keys * sizeof(uint64_t) +
+			                    header.nr_chunks * sizeof(Chunk<T>) +
+			                    header.nr_indexes * sizeof(Segment_index) };
+		auto const rows_end{ header.rows_offset + header.n * sizeof(T) };
+		if ((meta_size > header.rows_offset) || (rows_end > size))
+			throw corrupted;
+		auto const keys{ reinterpret_cast<uint64_t const*>(base + sizeof(Segment_header)) };
+		auto const chunks{ reinterpret_cast<Chunk<T> const*>(keys + header.nr_keys) };
+		manifest_ = Manifest<T>{ header.n,
+			                       std::vector<uint64_t>(keys, keys + header.nr_keys),
+			                       std::vector<Chunk<T>>(chunks, chunks + header.nr_chunks) };
+		size_t n{ 0 };
+		for (auto const& chunk : manifest_.chunks)
+			if (chunk.n > header.n - n)
+				throw corrupted;
+			else
+				n += chunk.n;
+		if (n != header.n)
+			throw corrupted;
+		auto const indexes{ reinterpret_cast<Segment_index const*>(chunks + header.nr_chunks) };
+		indexes_.assign(indexes, indexes + header.nr_indexes);
+		for (auto const& index : indexes_)
+			if ((index.name[sizeof(index.name) - 1] != '\0') || (index.offset < rows_end) ||
+			    (index.offset > size) || (index.size > size - index.offset) || (index.offset % 64 != 0))
+				throw corrupted;
+		rows_ = reinterpret_cast<T const*>(base + header.rows_offset);
+	}
+	// The published index of some data members; the index shares the segment with the table.
+	template<typename... Us>
+	Index<T, Us...> index(Us T::*... m_ptrs) const
+	{
+		auto const name{ get_index_name({ get_column(m_ptrs)... }) };
+		for (auto const& index : indexes_)
+			if (name == index.name)
+				return Index<T, Us...>{ mapping_,
+					                      static_cast<char const*>(mapping_->ptr_) + index.offset,
+					                      index.size,
+					                      get_table_hash(manifest_),
+					                      name };
+		throw Exception{ "the “" + name + "” index is not published" };
+	}
+	T const* data() const { return rows_; }
+	size_t size() const { return manifest_.n; }
+	bool empty() const { return size() == 0; }
+	T const* begin() const { return rows_; }
+	T const* end() const { return rows_ + size(); }
+	T const& operator[](size_t i) const { return rows_[i]; }
+	Manifest<T> const& manifest() const { return manifest_; }
+
+private:
+	static std::shared_ptr<Mapping const> map(str_t const& name)
+	{
+		auto const fd{ shm_open(name.c_str(), O_RDONLY, 0) };
+		if (fd < 0)
+			throw Exception{ "unable to open the “" + name + "” shared memory segment (" +
+				               std::strerror(errno) + ')' };
+		struct stat st;
+		if (fstat(fd, &st) != 0) {
+			close(fd);
+			throw Exception{ "unable to get the size of the “" + name + "” shared memory segment" };
+		}
+		void* const ptr{ (st.st_size == 0)
+			                 ? MAP_FAILED
+			                 : mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0) };
+		close(fd);
+		if (ptr == MAP_FAILED)
+			throw Exception{ "unable to map the “" + name + "” shared memory segment" };
+		return std::make_shared<Mapping const>(ptr, size_t(st.st_size));
+	}
+
+	std::shared_ptr<Mapping const> mapping_;
+	Manifest<T> manifest_;
+	std::vector<Segment_index> indexes_;
+	T const* rows_;
+};
+template<typename T>
+Shared_table<T>
+attach(str_t const& segment_name)
+{
+	return Shared_table<T>{ segment_name };
+}
+
+// Usage
+//   for ( auto const & row : table ) {
+//       if ( first(table, row.a) ) {
+//           ...
+//
+// It is presumed that table is sorted by the values of a. The function returns
+// true if it is the first row or if the value of a from the previous row is
+// not equal to the value of current row.
+template<typename T, typename A, typename U>
+bool
+first(std::vector<T, A> const& table, U const& u)
+{
+	auto const address_table{ reinterpret_cast<char const*>(&table[0]) };
+	auto const address_u{ reinterpret_cast<char const*>(&u) };
+	assert(address_table <= address_u);
+	// Narrowing initializations for the compiler...
+	size_t i = (address_u - address_table) / sizeof(T);
+	size_t offset = address_u - (address_table + i * sizeof(T));
+	if (i == 0)
+		return true;
+	return std::memcmp(address_table + (i - 1) * sizeof(T) + offset,
+	                   address_table + i * sizeof(T) + offset,
+	                   sizeof(U)) != 0;
+}
+template<typename T, typename A, typename U>
+bool
+last(std::vector<T, A> const& table, U const& u)
+{
+	auto const address_table{ reinterpret_cast<char const*>(&table[0]) };
+	auto const address_u{ reinterpret_cast<char const*>(&u) };
+	assert(address_table <= address_u);
+	auto const i{ size_t(address_u - address_table) / sizeof(T) };
+	auto const offset{ size_t(address_u - (address_table + i * sizeof(T))) };
+	if (i >= table.size())
+		return true;
+	return std::memcmp(address_table + i * sizeof(T) + offset,
+	                   address_table + (i + 1) * sizeof(T) + offset,
+	                   sizeof(U)) != 0;
+}
+// Scan kernels
+// auto const x{ column(table, &Row::x) };    // the values of x, with the stride of the rows
+// auto const y{ column(values) };            // the values of a vector, contiguous
+// auto const N{ count_not_missing(x) };
+// auto const s{ sum(x) }, lo{ min(x) }, hi{ max(x) }, m{ mean(x) };
+// auto const selection{ select(x, [](double x) { return x > 0; }) };
+// auto const s2{ sum(y, selection) };      // the selection can also be a Bitmap
+// The missing values are skipped: min and max are missing if all the values are missing, and mean
+// is NaN. The blocks are scanned by the pool. On x86-64, the int64_t and double columns are scanned
+// with AVX2 if the processor has it (gathers for the strided columns), otherwise by scalar loops.
+template<typename U>
+struct Column
+{
+	char const* ptr;
+	size_t n;
+	size_t stride;
+
+	size_t size() const { return n; }
+	bool contiguous() const { return stride == sizeof(U); }
+	U const& operator[](size_t i) const { return *reinterpret_cast<U const*>(ptr + i * stride); }
+};
+template<typename Table, typename T, typename U>
+Column<U>
+column(Table const& table, U T::*m_ptr)
+{
+	if (table.size() == 0)
+		return { nullptr, 0, sizeof(T) };
+	return { reinterpret_cast<char const*>(&(table.data()->*m_ptr)), table.size(), sizeof(T) };
+}
+template<typename U>
+Column<U>
+column(std::vector<U> const& values)
+{
+	return { reinterpret_cast<char const*>(values.data()), values.size(), sizeof(U) };
+}
+
+typedef std::vector<size_t> selection_t;
+
+// Bitmap const rows{ selection };           // from the sorted ids of some rows
+// rows.size(), rows.contains(i), rows & other, rows | other, rows.to_selection()
+// A compressed set of ids of rows, roaring-style: the ids are split by their high bits in
+// containers of 2^16 ids, stored as the sorted array of their low 16 bits if they hold at most
+// 4096 ids, and as a bitset of 1024 words otherwise.
+class Bitmap
+{
+public:
+	Bitmap() = default;
+	explicit Bitmap(selection_t const& rows)
+	{
+		for (size_t i{ 0 }; i < rows.size();) {
+			auto const key{ rows[i] >> 16 };
+			std::vector<uint16_t> lows;
+			for (; (i < rows.size()) && (rows[i] >> 16 == key); ++i)
+				lows.push_back(uint16_t(rows[i]));
+			add(key, std::move(lows));
+		}
+	}
+	// Add the container of the ids key * 2^16 + lows, after the other ones.
+	void add(size_t key, std::vector<uint16_t> lows)
+	{
+		assert(containers_.empty() || (containers_.back().key < key));
+		assert(std::is_sorted(begin(lows), end(lows)));
+		if (!lows.empty())
+			containers_.push_back(get_container(key, std::move(lows)));
+	}
+	size_t size() const
+	{
+		size_t rvo{ 0 };
+		for (auto const& container : containers_)
+			rvo += container.size();
+		return rvo;
+	}
+	bool empty() const { return containers_.empty(); }
+	bool contains(size_t row) const
+	{
+		auto const it{ std::lower_bound(
+		  begin(containers_), end(containers_), row >> 16, [](auto const& c, size_t key) {
+			  return c.key < key;
+		  }) };
+		return (it != end(containers_)) && (it->key == row >> 16) && it->contains(uint16_t(row));
+	}
+	selection_t to_selection() const
+	{
+		selection_t rvo;
+		rvo.reserve(size());
+		for (auto const& container : containers_)
+			container.for_each([&](uint16_t low) { rvo.push_back(container.key << 16 | low); });
+		return rvo;
+	}
+	friend Bitmap operator&(Bitmap const& a, Bitmap const& b)
+	{
+		Bitmap rvo;
+		auto i{ begin(a.containers_) }, j{ begin(b.containers_) };
+		while ((i != end(a.containers_)) && (j != end(b.containers_)))
+			if (i->key < j->key)
+				++i;
+			else if (j->key < i->key)
+				++j;
+			else {
+				auto container{ intersect(*i++, *j++) };
+				if (container.size() > 0)
+					rvo.containers_.push_back(std::move(container));
+			}
+		return rvo;
+	}
+	friend Bitmap operator|(Bitmap const& a, Bitmap const& b)
+	{
+		Bitmap rvo;
+		auto i{ begin(a.containers_) }, j{ begin(b.containers_) };
+		while ((i != end(a.containers_)) || (j != end(b.containers_)))
+			if ((j == end(b.containers_)) || ((i != end(a.containers_)) && (i->key < j->key)))
+				rvo.containers_.push_back(*i++);
+			else if ((i == end(a.containers_)) || (j->key < i->key))
+				rvo.containers_.push_back(*j++);
+			else
+				rvo.containers_.push_back(unite(*i++, *j++));
+		return rvo;
+	}
+
+private:
+	static constexpr size_t max_array{ 4096 };
+	static constexpr size_t nr_words{ (size_t(1) << 16) / 64 };
+	struct Container
+	{
+		size_t key;
+		std::vector<uint16_t> array;
+		// Empty, or the nr_words words of the bitset.
+		std::vector<uint64_t> bits;
+		size_t size() const
+		{
+			if (bits.empty())
+				return array.size();
+			size_t rvo{ 0 };
+			for (auto const word : bits)
+				rvo += __builtin_popcountll(word);
+			return rvo;
+		}
+		bool contains(uint16_t low) const
+		{
+			if (bits.empty())
+				return std::binary_search(begin(array), end(array), low);
+			return (bits[low / 64] >> (low % 64)) & 1;
+		}
+		// f(low) for the low bits of the ids, in increasing order.
+		template<typename F>
+		void for_each(F const& f) const
+		{
+			if (bits.empty())
+				std::for_each(begin(array), end(array), f);
+			else
+				for (size_t k{ 0 }; k < nr_words; ++k)
+					for (auto word{ bits[k] }; word != 0; word &= word - 1)
+						f(uint16_t(k * 64 + __builtin_ctzll(word)));
+		}
+		std::vector<uint64_t> get_bits() const
+		{
+			if (!bits.empty())
+				return bits;
+			std::vector<uint64_t> rvo(nr_words);
+			for (auto const low : array)
+				rvo[low / 64] |= uint64_t(1) << (low % 64);
+			return rvo;
+		}
+	};
+	static Container get_container(size_t key, std::vector<uint16_t> lows)
+	{
+		Container rvo{ key, std::move(lows), {} };
+		if (rvo.array.size() > max_array)
+			rvo.bits = rvo.get_bits(), rvo.array = {};
+		return rvo;
+	}
+	static Container get_container(size_t key, std::vector<uint64_t> bits)
+	{
+		Container rvo{ key, {}, std::move(bits) };
+		if (rvo.size() <= max_array) {
+			std::vector<uint16_t> lows;
+			rvo.for_each([&](uint16_t low) { lows.push_back(low); });
+			rvo.array = std::move(lows), rvo.bits = {};
+		}
+		return rvo;
+	}
+	static Container intersect(Container const& a, Container const& b)
+	{
+		if (!a.bits.empty() && !b.bits.empty()) {
+			std::vector<uint64_t> bits(nr_words);
+			for (size_t k{ 0 }; k < nr_words; ++k)
+				bits[k] = a.bits[k] & b.bits[k];
+			return get_container(a.key, std::move(bits));
+		}
+		std::vector<uint16_t> lows;
+		if (a.bits.empty() && b.bits.empty())
+			std::set_intersection(
+			  begin(a.array), end(a.array), begin(b.array), end(b.array), std::back_inserter(lows));
+		else {
+			auto const& array{ a.bits.empty() ? a : b };
+			auto const& bitset{ a.bits.empty() ? b : a };
+			for (auto const low : array.array)
+				if (bitset.contains(low))
+					lows.push_back(low);
+		}
+		return get_container(a.key, std::move(lows));
+	}
+	static Container unite(Container const& a, Container const& b)
+	{
+		if (a.bits.empty() && b.bits.empty()) {
+			std::vector<uint16_t> lows;
+			std::set_union(
+			  begin(a.array), end(a.array), begin(b.array), end(b.array), std::back_inserter(lows));
+			return get_container(a.key, std::move(lows));
+		}
+		auto bits{ a.get_bits() };
+		if (b.bits.empty())
+			for (auto const low : b.array)
+				bits[low / 64] |= uint64_t(1) << (low % 64);
+		else
+			for (size_t k{ 0 }; k < nr_words; ++k)
+				bits[k] |= b.bits[k];
+		return get_container(a.key, std::move(bits));
+	}
+
+	std::vector<Container> containers_;
+};
+
+namespace internals {
+// The partial results of a scan.
+template<typename U>
+struct Scan
+{
+	size_t n;
+	U sum;
+	U min;
+	U max;
+};
+// The min and max of the doubles start at the infinities, like the AVX2 scan: an infinite value is
+// then its own min or max.
+template<typename U>
+Scan<U>
+get_scan()
+{
+	if constexpr (std::numeric_limits<U>::has_infinity)
+		return { 0, U{ 0 }, std::numeric_limits<U>::infinity(), -std::numeric_limits<U>::infinity() };
+	else
+		return { 0, U{ 0 }, std::numeric_limits<U>::max(), std::numeric_limits<U>::lowest() };
+}
+template<typename U>
+void
+add(Scan<U>& scan, U x)
+{
+	if (missing(x))
+		return;
+	++scan.n, scan.sum += x;
+	scan.min = std::min(scan.min, x), scan.max = std::max(scan.max, x);
+}
+template<typename U>
+void
+add(Scan<U>& scan, Scan<U> const& other)
+{
+	scan.n += other.n, scan.sum += other.sum;
+	scan.min = std::min(scan.min, other.min), scan.max = std::max(scan.max, other.max);
+}
+template<typename U>
+Scan<U>
+scan_scalar(Column<U> const& column, size_t start, size_t end)
+{
+	auto rvo{ get_scan<U>() };
+	for (auto i{ start }; i < end; ++i)
+		add(rvo, column[i]);
+	return rvo;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+inline bool
+has_avx2()
+{
+	static bool const rvo{ __builtin_cpu_supports("avx2") != 0 };
+	return rvo;
+}
+__attribute__((target("avx2"))) inline Scan<double>
+scan_avx2(Column<double> const& column, size_t start, size_t end)
+{
+	auto const stride{ static_cast<long long>(column.stride) };
+	auto const offsets{ _mm256_set_epi64x(3 * stride, 2 * stride, stride, 0) };
+	auto const inf{ _mm256_set1_pd(std::numeric_limits<double>::infinity()) };
+	auto sum{ _mm256_setzero_pd() }, min{ inf }, max{ _mm256_sub_pd(_mm256_setzero_pd(), inf) };
+	size_t n{ 0 }, i{ start };
+	for (; i + 4 <= end; i += 4) {
+		auto const p{ reinterpret_cast<double const*>(column.ptr + i * column.stride) };
+		auto const x{ column.contiguous() ? _mm256_loadu_pd(p) : _mm256_i64gather_pd(p, offsets, 1) };
+		// All ones for the values that are not NaN.
+		auto const ok{ _mm256_cmp_pd(x, x, _CMP_ORD_Q) };
+		sum = _mm256_add_pd(sum, _mm256_and_pd(x, ok));
+		min = _mm256_min_pd(min, _mm256_blendv_pd(inf, x, ok));
+		max = _mm256_max_pd(max, _mm256_blendv_pd(_mm256_sub_pd(_mm256_setzero_pd(), inf), x, ok));
+		n += __builtin_popcount(_mm256_movemask_pd(ok));
+	}
+	alignas(32) double sums[4], mins[4], maxs[4];
+	_mm256_store_pd(sums, sum), _mm256_store_pd(mins, min), _mm256_store_pd(maxs, max);
+	auto rvo{ scan_scalar(column, i, end) };
+	rvo.n += n;
+	for (int k{ 0 }; k < 4; ++k) {
+		rvo.sum += sums[k];
+		rvo.min = std::min(rvo.min, mins[k]), rvo.max = std::max(rvo.max, maxs[k]);
+	}
+	return rvo;
+}
+__attribute__((target("avx2"))) inline Scan<int64_t>
+scan_avx2(Column<int64_t> const& column, size_t start, size_t end)
+{
+	auto const stride{ static_cast<long long>(column.stride) };
+	auto const offsets{ _mm256_set_epi64x(3 * stride, 2 * stride, stride, 0) };
+	auto const highest{ _mm256_set1_epi64x(std::numeric_limits<int64_t>::max()) };
+	auto const lowest{ _mm256_set1_epi64x(std::numeric_limits<int64_t>::lowest()) };
+	auto sum{ _mm256_setzero_si256() }, min{ highest }, max{ lowest };
+	size_t n{ 0 }, i{ start };
+	for (; i + 4 <= end; i += 4) {
+		auto const p{ reinterpret_cast<long long const*>(column.ptr + i * column.stride) };
+		auto const x{ column.contiguous() ? _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p))
+		                                  : _mm256_i64gather_epi64(p, offsets, 1) };
+		// All ones for the missing values, INT64_MAX: they are already neutral for min.
+		auto const no{ _mm256_cmpeq_epi64(x, highest) };
+		sum = _mm256_add_epi64(sum, _mm256_andnot_si256(no, x));
+		min = _mm256_blendv_epi8(min, x, _mm256_cmpgt_epi64(min, x));
+		auto const y{ _mm256_blendv_epi8(x, lowest, no) };
+		max = _mm256_blendv_epi8(max, y, _mm256_cmpgt_epi64(y, max));
+		n += 4 - __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(no)));
+	}
+	alignas(32) int64_t sums[4], mins[4], maxs[4];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(sums), sum);
+	_mm256_store_si256(reinterpret_cast<__m256i*>(mins), min);
+	_mm256_store_si256(reinterpret_cast<__m256i*>(maxs), max);
+	auto rvo{ scan_scalar(column, i, end) };
+	rvo.n += n;
+	for (int k{ 0 }; k < 4; ++k) {
+		rvo.sum += sums[k];
+		rvo.min = std::min(rvo.min, mins[k]), rvo.max = std::max(rvo.max, maxs[k]);
+	}
+	return rvo;
+}
+#endif
+
+template<typename U>
+Scan<U>
+scan_block(Column<U> const& column, size_t start, size_t end)
+{
+#if defined(__GNUC__) && defined(__x86_64__)
+	if (has_avx2())
+		return scan_avx2(column, start, end);
+#endif
+	return scan_scalar(column, start, end);
+}
+template<typename U>
+Scan<U>
+scan(Column<U> const& column)
+{
+	static_assert(std::is_same_v<U, int64_t> || std::is_same_v<U, double>);
+	std::vector<Scan<U>> scans((column.size() + chunk_rows - 1) / chunk_rows);
+	for_each_block(column.size(), [&](size_t start, size_t end) {
+		scans[start / chunk_rows] = scan_block(column, start, end);
+	});
+	auto rvo{ get_scan<U>() };
+	for (auto const& scan : scans)
+		add(rvo, scan);
+	return rvo;
+}
+template<typename U>
+Scan<U>
+scan(Column<U> const& column, selection_t const& selection)
+{
+	static_assert(std::is_same_v<U, int64_t> || std::is_same_v<U, double>);
+	std::vector<Scan<U>> scans((selection.size() + chunk_rows - 1) / chunk_rows);
+	for_each_block(selection.size(), [&](size_t start, size_t end) {
+		auto& scan{ scans[start / chunk_rows] = get_scan<U>() };
+		for (auto i{ start }; i < end; ++i)
+			add(scan, column[selection[i]]);
+	});
+	auto rvo{ get_scan<U>() };
+	for (auto const& scan : scans)
+		add(rvo, scan);
+	return rvo;
+}
+template<typename U>
+Scan<U>
+scan(Column<U> const& column, Bitmap const& bitmap)
+{
+	return scan(column, bitmap.to_selection());
+}
+} // namespace internals
+
+template<typename U, typename... Selection>
+size_t
+count_not_missing(Column<U> const& column, Selection const&... selection)
+{
+	if constexpr (std::is_same_v<U, int64_t> || std::is_same_v<U, double>)
+		return internals::scan(column, selection...).n;
+	else {
+		static_assert(sizeof...(Selection) == 0);
+		std::vector<size_t> counts((column.size() + chunk_rows - 1) / chunk_rows);
+		for_each_block(column.size(), [&](size_t start, size_t end) {
+			size_t n{ 0 };
+			for (auto i{ start }; i < end; ++i)
+				n += !missing(column[i]);
+			counts[start / chunk_rows] = n;
+		});
+		return std::accumulate(begin(counts), end(counts), size_t{ 0 });
+	}
+}
+template<typename U, typename... Selection>
+U
+sum(Column<U> const& column, Selection const&... selection)
+{
+	return internals::scan(column, selection...).sum;
+}
+template<typename U, typename... Selection>
+U
+min(Column<U> const& column, Selection const&... selection)
+{
+	auto const scan{ internals::scan(column, selection...) };
+	auto rvo{ scan.min };
+	if (scan.n == 0)
+		set_missing(rvo);
+	return rvo;
+}
+template<typename U, typename... Selection>
+U
+max(Column<U> const& column, Selection const&... selection)
+{
+	auto const scan{ internals::scan(column, selection...) };
+	auto rvo{ scan.max };
+	if (scan.n == 0)
+		set_missing(rvo);
+	return rvo;
+}
+template<typename U, typename... Selection>
+double
+mean(Column<U> const& column, Selection const&... selection)
+{
+	auto const scan{ internals::scan(column, selection...) };
+	return scan.n == 0 ? std::numeric_limits<double>::quiet_NaN() : double(scan.sum) / scan.n;
+}
+
+namespace internals {
+// The bit i % 64 of the word i / 64 is set if pred(i), for i in [0, n). The flags are computed
+// without any branch, 64 values at a time.
+template<typename P>
+std::vector<uint64_t>
+get_bitmap(size_t n, P const& pred)
+{
+	std::vector<uint64_t> rvo((n + 63) / 64);
+	for_each_block(n, [&](size_t start, size_t end) {
+		for (auto i{ start }; i < end; i += 64) {
+			uint64_t word{ 0 };
+			for (size_t j{ 0 }; j < std::min(size_t(64), end - i); ++j)
+				word |= uint64_t(bool(pred(i + j))) << j;
+			rvo[i / 64] = word;
+		}
+	});
+	return rvo;
+}
+} // namespace internals
+// The bit i % 64 of the word i / 64 is set if pred(column[i]).
+template<typename U, typename P>
+std::vector<uint64_t>
+to_bitmap(Column<U> const& column, P const& pred)
+{
+	return internals::get_bitmap(column.size(), [&](size_t i) { return pred(column[i]); });
+}
+// The positions of the bits that are set, in increasing order.
+inline selection_t
+to_selection(std::vector<uint64_t> const& bitmap)
+{
+	std::vector<selection_t> parts((bitmap.size() * 64 + chunk_rows - 1) / chunk_rows);
+	for_each_block(bitmap.size() * 64, [&](size_t start, size_t end) {
+		auto& part{ parts[start / chunk_rows] };
+		for (auto k{ start / 64 }; k < end / 64; ++k)
+			for (auto word{ bitmap[k] }; word != 0; word &= word - 1)
+				part.push_back(k * 64 + __builtin_ctzll(word));
+	});
+	selection_t rvo;
+	for (auto const& part : parts)
+		rvo.insert(end(rvo), begin(part), end(part));
+	return rvo;
+}
+// The rows for which pred(column[i]) is true, in increasing order.
+template<typename U, typename P>
+selection_t
+select(Column<U> const& column, P const& pred)
+{
+	return to_selection(to_bitmap(column, pred));
+}
+
+// parallel_for_each(table, [](auto const& row) { ... });
+// auto const selection{ parallel_filter(table, [](auto const& row) { return row.x > 0; }) };
+// auto const total{ parallel_transform_reduce(table, 0., std::plus<>{},
+//                                             [](auto const& row) { return row.x; }) };
+// The table is a vector, a span or a shared table. The rows are processed by the pool, a block of
+// chunk_rows rows at a time, so f is called concurrently. The results of the blocks are reduced in
+// the order of the blocks, after init: the result does not depend on the number of threads.
+template<typename Table, typename F>
+void
+parallel_for_each(Table const& table, F const& f)
+{
+	auto const rows{ std::begin(table) };
+	for_each_block(table.size(), [&](size_t start, size_t end) {
+		for (auto i{ start }; i < end; ++i)
+			f(rows[i]);
+	});
+}
+template<typename Table, typename P>
+selection_t
+parallel_filter(Table const& table, P const& pred)
+{
+	auto const rows{ std::begin(table) };
+	return to_selection(internals::get_bitmap(table.size(), [&](size_t i) { return pred(rows[i]); }));
+}
+template<typename Table, typename V, typename Reduce, typename Transform>
+V
+parallel_transform_reduce(Table const& table,
+                          V init,
+                          Reduce const& reduce,
+                          Transform const& transform)
+{
+	auto const rows{ std::begin(table) };
+	std::vector<std::optional<V>> results((table.size() + chunk_rows - 1) / chunk_rows);
+	for_each_block(table.size(), [&](size_t start, size_t end) {
+		V result{ transform(rows[start]) };
+		for (auto i{ start + 1 }; i < end; ++i)
+			result = reduce(std::move(result), transform(rows[i]));
+		results[start / chunk_rows] = std::move(result);
+	});
+	for (auto& result : results)
+		init = reduce(std::move(init), std::move(*result));
+	return init;
+}
+
+// auto const region{ bitmap_index(table, &Row::region) };
+// auto const status{ bitmap_index(table, &Row::status) };
+// auto const rows{ (region.equal("north") | region.equal("south")) & status.equal(2) };
+// auto const total{ sum(column(table, &Row::amount), rows) };
+// The bitmaps of the rows of each value, for the data members with few distinct values; the
+// missing values have their own bitmap. The blocks of chunk_rows rows, which are the containers of
+// the bitmaps, are indexed by the pool.
+template<typename T, typename U>
+class Bitmap_index
+{
+public:
+	template<typename Table>
+	Bitmap_index(Table const& table, U T::*m_ptr)
+	{
+		static_assert(chunk_rows == (size_t(1) << 16), "a block of rows is a container");
+		struct Less
+		{
+			bool operator()(U const& a, U const& b) const { return less(a, b); }
+		};
+		auto const rows{ std::begin(table) };
+		std::vector<std::map<U, std::vector<uint16_t>, Less>> blocks(
+		  (table.size() + chunk_rows - 1) / chunk_rows);
+		for_each_block(table.size(), [&](size_t start, size_t end) {
+			auto& block{ blocks[start / chunk_rows] };
+			for (auto i{ start }; i < end; ++i)
+				block[rows[i].*m_ptr].push_back(uint16_t(i - start));
+		});
+		std::map<U, Bitmap, Less> bitmaps;
+		for (size_t b{ 0 }; b < blocks.size(); ++b)
+			for (auto& [u, lows] : blocks[b])
+				bitmaps[u].add(b, std::move(lows));
+		for (auto& [u, bitmap] : bitmaps)
+			if (missing(u))
+				missing_ = std::move(bitmap);
+			else
+				values_.push_back(u), bitmaps_.push_back(std::move(bitmap));
+	}
+	// The distinct values which are not missing, in increasing order.
+	std::vector<U> const& values() const { return values_; }
+	template<typename K>
+	Bitmap const& equal(K const& key) const
+	{
+		auto const u{ Key<U>::get(key) };
+		auto const it{ std::lower_bound(
+		  begin(values_), end(values_), u, [](U const& a, U const& b) { return less(a, b); }) };
+		if ((it == end(values_)) || less(u, *it))
+			return empty_;
+		return bitmaps_[it - begin(values_)];
+	}
+	Bitmap const& missing_rows() const { return missing_; }
+
+private:
+	std::vector<U> values_;
+	std::vector<Bitmap> bitmaps_;
+	Bitmap missing_;
+	Bitmap empty_;
+};
+template<typename Table, typename T, typename U>
+Bitmap_index<T, U>
+bitmap_index(Table const& table, U T::*m_ptr)
+{
+	return { table, m_ptr };
+}
+
+// auto const N { not_missing(table, &Row::member) };
+template<typename T, typename A, typename U>
+size_t
+not_missing(std::vector<T, A> const& table, U T::*m_ptr)
+{
+	return count_not_missing(column(table, m_ptr));
+}
+template<typename T, typename A>
+size_t
+num_obs(std::vector<T, A> const& table, T const& row)
+{
+	assert(&row >= &table[0]);
+	return &row - &table[0];
+}
+// auto const runs{ group_runs(table, &Row::a, &Row::b) };
+// for (auto const& run : runs)              // the runs of rows with equal values of a and b
+//     for (auto const& row : run) ...
+// runs.for_each([](auto const& run) { ... }); // the same, by the pool
+// It is presumed that the table is sorted by a and b. Like first and last, the values are equal if
+// their bytes are equal. The boundaries of the runs are found by the pool, a block of rows at a
+// time: the comparisons of the rows are stored in a vector of flags, without any branch, then the
+// flags are collected.
+template<typename T>
+class Runs
+{
+public:
+	class Iterator
+	{
+	public:
+		Iterator(Runs const* runs, size_t k)
+		  : runs_(runs)
+		  , k_(k)
+		{}
+		Span<T> operator*() const { return (*runs_)[k_]; }
+		Iterator& operator++()
+		{
+			++k_;
+			return *this;
+		}
+		bool operator!=(Iterator const& it) const { return k_ != it.k_; }
+
+	private:
+		Runs const* runs_;
+		size_t k_;
+	};
+	Runs(T const* rows, std::vector<size_t> bounds)
+	  : rows_(rows)
+	  , bounds_(std::move(bounds))
+	{}
+	size_t size() const { return bounds_.size() - 1; }
+	Span<T> operator[](size_t k) const { return { rows_ + bounds_[k], rows_ + bounds_[k + 1] }; }
+	Iterator begin() const { return { this, 0 }; }
+	Iterator end() const { return { this, size() }; }
+	// Call f(run) for each run by the pool; a task handles the runs of about chunk_rows rows.
+	template<typename F>
+	void for_each(F const& f) const
+	{
+		std::vector<size_t> tasks{ 0 };
+		for (size_t k{ 0 }; k < size(); ++k)
+			if (bounds_[k + 1] - bounds_[tasks.back()] >= chunk_rows)
+				tasks.push_back(k + 1);
+		if (tasks.back() != size())
+			tasks.push_back(size());
+		pool().run(tasks.size() - 1, [&](size_t t) {
+			for (auto k{ tasks[t] }; k < tasks[t + 1]; ++k)
+				f((*this)[k]);
+		});
+	}
+
+private:
+	T const* rows_;
+	// The run k is made of the rows in [bounds_[k], bounds_[k + 1]).
+	std::vector<size_t> bounds_;
+};
+template<typename Table, typename T, typename... Us>
+Runs<T>
+group_runs(Table const& table, Us T::*... m_ptrs)
+{
+	auto const rows{ table.data() };
+	auto const n{ table.size() };
+	std::vector<std::vector<size_t>> starts((n + chunk_rows - 1) / chunk_rows);
+	for_each_block(n, [&](size_t start, size_t end) {
+		std::vector<unsigned char> flags(end - start, 1);
+		for (auto i{ std::max(start, size_t(1)) }; i < end; ++i)
+			flags[i - start] =
+			  ((std::memcmp(&(rows[i].*m_ptrs), &(rows[i - 1].*m_ptrs), sizeof(Us)) != 0) | ...);
+		auto& block{ starts[start / chunk_rows] };
+		for (auto i{ start }; i < end; ++i)
+			if (flags[i - start])
+				block.push_back(i);
+	});
+	std::vector<size_t> bounds;
+	for (auto const& block : starts)
+		bounds.insert(end(bounds), cbegin(block), cend(block));
+	bounds.push_back(n);
+	return { rows, std::move(bounds) };
+}
+namespace internals {
+// The last row of the key, like the map index used to build, or an exception.
+template<typename T, typename A, typename U>
+size_t
+find_last(std::vector<T, A> const& table, U T::*m_ptr, U const& key)
+{
+	for (auto i{ table.size() }; i > 0; --i)
+		if (!less(table[i - 1].*m_ptr, key) && !less(key, table[i - 1].*m_ptr))
+			return i - 1;
+	throw Exception{ "key “" + std::to_string(key) + "“ not found" };
+}
+} // namespace internals
+
+// index(table, &Row::member, key)
+// Deprecated: each call scans the table, nothing is cached. Build an Index on the table instead,
+// whose at() gives the first row of a duplicate key where index gives the last one.
+template<typename T, typename A, typename U>
+[[deprecated("build an Index on the table")]] size_t
+index(std::vector<T, A> const& table, U T::*m_ptr, U const& key)
+{
+	return internals::find_last(table, m_ptr, key);
+}
+//  xt::index(table, &Row::member, key, &Row::get_member)
+template<typename T, typename A, typename U, typename V>
+[[deprecated("build an Index on the table")]] V
+index(std::vector<T, A> const& table, U T::*m_ptr, U const& key, V T::*m_get_ptr)
+{
+	return table[internals::find_last(table, m_ptr, key)].*m_get_ptr;
+}
+// Hash of the keys, consistent with compare: the zeros and the NaN have one hash each.
+uint64_t
+mix(uint64_t h, uint64_t x)
+{
+	x += h + 0x9e3779b97f4a7c15ull;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+	return x ^ (x >> 31);
+}
+uint64_t
+hash_value(int64_t i, uint64_t h)
+{
+	return mix(h, uint64_t(i));
+}
+uint64_t
+hash_value(double x, uint64_t h)
+{
+	if (std::isnan(x))
+		x = std::numeric_limits<double>::quiet_NaN();
+	else if (x == 0)
+		x = 0;
+	uint64_t u;
+	std::memcpy(&u, &x, sizeof(u));
+	return mix(h, u);
+}
+// Up to the first null char, so the strings of different widths have the same hash.
+template<size_t N>
+uint64_t
+hash_value(std::array<char, N> const& a, uint64_t h)
+{
+	return mix(h, hash(a.data(), std::find(cbegin(a), cend(a), '\0') - cbegin(a)));
+}
+struct Key_hash
+{
+	template<typename... Us>
+	size_t operator()(std::tuple<Us...> const& key) const
+	{
+		uint64_t h{ 0 };
+		std::apply([&](auto const&... u) { ((h = hash_value(u, h)), ...); }, key);
+		return h;
+	}
+};
+struct Key_equal
+{
+	template<typename... Us>
+	bool operator()(std::tuple<Us...> const& a, std::tuple<Us...> const& b) const
+	{
+		return compare(a, b) == 0;
+	}
+};
+
+// auto const groups{ group_by(table, keys(&Row::region, &Row::year), count(), sum(&Row::amount),
+//                             mean(&Row::price)) };
+// for (auto const& group : groups)
+//     std::cout << std::get<0>(group.key) << ' ' << group.n << ' ' << group.values[1] << '\n';
+// The groups are sorted by key. The values of the aggregates are in the order of the arguments;
+// count() is the number of rows of the group, the other aggregates skip the missing values (the
+// min, max and mean of missing values are NaN). The int64_t members are aggregated as integers,
+// also given exactly by group.integers. Each block of rows is aggregated by the pool in a
+// hash table, partitioned by the hash of the keys, then the partitions are merged by the pool.
+enum class Kind
+{
+	count,
+	sum,
+	min,
+	max,
+	mean,
+};
+template<typename T, typename... Us>
+struct Keys
+{
+	std::tuple<Us T::*...> m_ptrs;
+};
+template<typename T, typename... Us>
+Keys<T, Us...>
+keys(Us T::*... m_ptrs)
+{
+	return { { m_ptrs... } };
+}
+// The values of an aggregate: the int64_t values are summed, and compared, as integers; they are
+// converted once, for the double value. If the sum of the integers overflows, it is missing, and
+// the double value is the sum of the converted values.
+struct Accumulator
+{
+	size_t n{ 0 };
+	double sum{ 0 };
+	double min{ std::numeric_limits<double>::infinity() };
+	double max{ -std::numeric_limits<double>::infinity() };
+	bool integer{ false };
+	bool overflow{ false };
+	int64_t integer_sum{ 0 };
+	int64_t integer_min{ std::numeric_limits<int64_t>::max() };
+	int64_t integer_max{ std::numeric_limits<int64_t>::lowest() };
+	void add(double x) { ++n, sum += x, min = std::min(min, x), max = std::max(max, x); }
+	void add(int64_t i)
+	{
+		integer = true, ++n, sum += double(i), add_integer(i);
+		integer_min = std::min(integer_min, i), integer_max = std::max(integer_max, i);
+	}
+	// A value counted only.
+	void add() { ++n; }
+	void merge(Accumulator const& a)
+	{
+		n += a.n, sum += a.sum, min = std::min(min, a.min), max = std::max(max, a.max);
+		integer = integer || a.integer, overflow = overflow || a.overflow;
+		add_integer(a.integer_sum);
+		integer_min = std::min(integer_min, a.integer_min);
+		integer_max = std::max(integer_max, a.integer_max);
+	}
+	void add_integer(int64_t i)
+	{
+		if ((i > 0) ? (integer_sum > std::numeric_limits<int64_t>::max() - i)
+		            : (integer_sum < std::numeric_limits<int64_t>::lowest() - i))
+			overflow = true;
+		else
+			integer_sum += i;
+	}
+	double value(Kind kind) const
+	{
+		auto const nan{ std::numeric_limits<double>::quiet_NaN() };
+		if (integer && !overflow && (kind == Kind::sum))
+			return double(integer_sum);
+		if (integer && !overflow && (kind == Kind::mean))
+			return n ? double(integer_sum) / double(n) : nan;
+		if (integer && ((kind == Kind::min) || (kind == Kind::max)))
+			return n ? double(integer_value(kind)) : nan;
+		switch (kind) {
+			case Kind::count:
+				return double(n);
+			case Kind::sum:
+				return sum;
+			case Kind::min:
+				return n ? min : nan;
+			case Kind::max:
+				return n ? max : nan;
+			case Kind::mean:
+				return n ? sum / n : nan;
+		}
+		return nan;
+	}
+	// The exact count, and the exact sum, min and max of the int64_t values; missing otherwise.
+	int64_t integer_value(Kind kind) const
+	{
+		auto const none{ std::numeric_limits<int64_t>::max() };
+		switch (kind) {
+			case Kind::count:
+				return int64_t(n);
+			case Kind::sum:
+				return (integer && !overflow) ? integer_sum : none;
+			case Kind::min:
+				return (integer && n) ? integer_min : none;
+			case Kind::max:
+				return (integer && n) ? integer_max : none;
+			case Kind::mean:
+				return none;
+		}
+		return none;
+	}
+};
+struct Count_rows
+{
+	static constexpr Kind kind{ Kind::count };
+	template<typename T>
+	void add(T const&, Accumulator& accumulator) const
+	{
+		accumulator.add();
+	}
+};
+template<Kind K, typename T, typename U>
+struct Aggregate
+{
+	static_assert((K == Kind::count) || std::is_arithmetic_v<U>,
+	              "only the number of values of a string is aggregated");
+	static constexpr Kind kind{ K };
+	U T::*m_ptr;
+	void add(T const& row, Accumulator& accumulator) const
+	{
+		auto const& u{ row.*m_ptr };
+		if (missing(u))
+			return;
+		if constexpr (std::is_arithmetic_v<U>)
+			accumulator.add(u);
+		else
+			accumulator.add();
+	}
+};
+Count_rows
+count()
+{
+	return {};
+}
+// The number of values which are not missing.
+template<typename T, typename U>
+Aggregate<Kind::count, T, U>
+count(U T::*m_ptr)
+{
+	return { m_ptr };
+}
+template<typename T, typename U>
+Aggregate<Kind::sum, T, U>
+sum(U T::*m_ptr)
+{
+	return { m_ptr };
+}
+template<typename T, typename U>
+Aggregate<Kind::min, T, U>
+min(U T::*m_ptr)
+{
+	return { m_ptr };
+}
+template<typename T, typename U>
+Aggregate<Kind::max, T, U>
+max(U T::*m_ptr)
+{
+	return { m_ptr };
+}
+template<typename T, typename U>
+Aggregate<Kind::mean, T, U>
+mean(U T::*m_ptr)
+{
+	return { m_ptr };
+}
+
+
+template<typename Key, size_t K>
+struct Group
+{
+	Key key;
+	size_t n;
+	std::array<double, K> values;
+	// The exact counts, and sums, mins and maxes of the int64_t members; missing otherwise.
+	std::array<int64_t, K> integers;
+};
+
+template<typename Table, typename T, typename... Us, typename... Aggregates>
+std::vector<Group<std::tuple<Us...>, sizeof...(Aggregates)>>
+group_by(Table const& table, Keys<T, Us...> const& keys, Aggregates const&... aggregates)
+{
+	using key_type = std::tuple<Us...>;
+	constexpr size_t K{ sizeof...(Aggregates) };
+	struct State
+	{
+		size_t n{ 0 };
+		std::array<Accumulator, K> accumulators;
+	};
+	using Map = std::unordered_map<key_type, State, Key_hash, Key_equal>;
+	auto const rows{ table.data() };
+	auto const n{ table.size() };
+	auto const nr_blocks{ (n + chunk_rows - 1) / chunk_rows };
+	auto const nr_parts{ pool().size() };
+	auto const get_part{ [&](key_type const& key) { return (Key_hash{}(key) >> 32) % nr_parts; } };
+	// The maps of the partitions of each block.
+	std::vector<std::vector<Map>> maps(nr_blocks, std::vector<Map>(nr_parts));
+	for_each_block(n, [&](size_t start, size_t end) {
+		auto& parts{ maps[start / chunk_rows] };
+		for (auto i{ start }; i < end; ++i) {
+			auto const key{ std::apply([&](auto... m_ptr) { return key_type{ rows[i].*m_ptr... }; },
+			                           keys.m_ptrs) };
+			auto& state{ parts[get_part(key)][key] };
+			++state.n;
+			size_t k{ 0 };
+			(aggregates.add(rows[i], state.accumulators[k++]), ...);
+		}
+	});
+	pool().run(nr_parts, [&](size_t p) {
+		for (size_t b{ 1 }; b < nr_blocks; ++b) {
+			for (auto const& [key, state] : maps[b][p]) {
+				auto& merged{ maps[0][p][key] };
+				merged.n += state.n;
+				for (size_t k{ 0 }; k < K; ++k)
+					merged.accumulators[k].merge(state.accumulators[k]);
+			}
+			Map{}.swap(maps[b][p]);
+		}
+	});
+	std::vector<Group<key_type, K>> rvo;
+	if (nr_blocks == 0)
+		return rvo;
+	for (auto const& part : maps[0])
+		for (auto const& [key, state] : part) {
+			Group<key_type, K> group{ key, state.n, {}, {} };
+			size_t k{ 0 };
+			((group.values[k] = state.accumulators[k].value(aggregates.kind),
+			  group.integers[k] = state.accumulators[k].integer_value(aggregates.kind),
+			  ++k),
+			 ...);
+			rvo.push_back(group);
+		}
+	parallel_sort(rvo, [](auto const& g, auto const& h) { return compare(g.key, h.key) < 0; });
+	return rvo;
+}
+
+// auto const pairs{ join(left, &L::k, right, &R::k) };            // the ids of the equal keys
+// auto const pairs{ join(left, &L::k, right, &R::k, Join::left) }; // and (i, npos) if no match
+// join(left, &L::k, right, &R::k, Join::inner, [](size_t i, size_t j) { ... });
+// The missing keys match no key. The keys have the same type, or are strings of any widths, equal
+// up to their first null char. The pairs are sorted by the left rows, then by the right rows; f
+// is called by the pool, in no particular order. A hash table is built on the smaller table (the
+// right one for a left join), partitioned by the high bits of the hashes of the keys, then the
+// other table is probed by the pool, a block of rows at a time.
+enum class Join
+{
+	inner,
+	left,
+};
+constexpr size_t npos{ std::numeric_limits<size_t>::max() };
+
+namespace internals {
+bool
+equal_key(int64_t i, int64_t j)
+{
+	return i == j;
+}
+bool
+equal_key(double x, double y)
+{
+	return !less(x, y) && !less(y, x);
+}
+template<size_t N, size_t M>
+bool
+equal_key(std::array<char, N> const& a, std::array<char, M> const& b)
+{
+	auto const n{ size_t(std::find(cbegin(a), cend(a), '\0') - cbegin(a)) };
+	auto const m{ size_t(std::find(cbegin(b), cend(b), '\0') - cbegin(b)) };
+	return (n == m) && (std::memcmp(a.data(), b.data(), n) == 0);
+}
+
+// The ids of the rows by key: the rows are scattered by partition, then each partition is chained
+// in the buckets of the low bits of the hashes.
+template<typename T, typename U>
+class Hash_table
+{
+public:
+	Hash_table(T const* rows, size_t n, U T::*m_ptr)
+	  : rows_(rows)
+	  , m_ptr_(m_ptr)
+	{
+		while ((size_t(1) << bits_) < 4 * pool().size())
+			++bits_;
+		auto const nr_parts{ size_t(1) << bits_ };
+		std::vector<uint64_t> hashes(n);
+		for_each_block(n, [&](size_t start, size_t end) {
+			for (auto i{ start }; i < end; ++i)
+				hashes[i] = hash_value(rows[i].*m_ptr, 0);
+		});
+		// The missing keys go to a last partition, which is not chained.
+		auto const get_part{ [&](size_t i) {
+			return missing(rows[i].*m_ptr) ? nr_parts : size_t(hashes[i] >> (64 - bits_));
+		} };
+		ids_.resize(n), hashes_.resize(n), next_.resize(n);
+		auto bounds{ scatter(n, nr_parts + 1, get_part, [&](size_t i, size_t j) {
+			ids_[j] = i, hashes_[j] = hashes[i];
+		}) };
+		if (bounds.empty() && (n > 0)) {
+			// A single partition: nothing was moved.
+			std::iota(begin(ids_), end(ids_), 0);
+			hashes_ = hashes;
+			bounds.assign(nr_parts + 2, 0);
+			for (auto p{ get_part(0) + 1 }; p < bounds.size(); ++p)
+				bounds[p] = n;
+		}
+		if (n == 0)
+			return;
+		heads_.resize(nr_parts);
+		pool().run(nr_parts, [&](size_t p) {
+			size_t nr_buckets{ 1 };
+			while (nr_buckets < bounds[p + 1] - bounds[p])
+				nr_buckets *= 2;
+			auto& heads{ heads_[p] };
+			heads.assign(nr_buckets, npos);
+			// From the last one, so the rows of a key are chained in order.
+			for (auto e{ bounds[p + 1] }; e-- > bounds[p];) {
+				auto& head{ heads[hashes_[e] & (heads.size() - 1)] };
+				next_[e] = std::exchange(head, e);
+			}
+		});
+	}
+	// f(row) for the rows whose key is equal to key, in order.
+	template<typename V, typename F>
+	void for_each_match(V const& key, F const& f) const
+	{
+		if (missing(key) || heads_.empty())
+			return;
+		auto const h{ hash_value(key, 0) };
+		auto const& heads{ heads_[h >> (64 - bits_)] };
+		for (auto e{ heads[h & (heads.size() - 1)] }; e != npos; e = next_[e]) {
+			auto const& u{ rows_[ids_[e]].*m_ptr_ };
+			if ((hashes_[e] == h) && equal_key(u, key))
+				f(ids_[e]);
+		}
+	}
+
+private:
+	T const* rows_;
+	U T::*m_ptr_;
+	int bits_{ 1 };
+	std::vector<size_t> ids_;
+	std::vector<uint64_t> hashes_;
+	std::vector<size_t> next_;
+	std::vector<std::vector<size_t>> heads_;
+};
+// f(start, i, j) for the pairs, where start is the first row of the block of the probed table.
+// Returns true if the right table was probed.
+template<typename Left, typename L, typename Right, typename R, typename U, typename V, typename F>
+bool
+join_blocks(Left const& left, U L::*l_ptr, Right const& right, V R::*r_ptr, Join kind, F const& f)
+{
+	static_assert(std::is_same_v<U, V> || (!std::is_arithmetic_v<U> && !std::is_arithmetic_v<V>),
+	              "the keys of a join are of the same type, or strings");
+	auto const l_rows{ left.data() };
+	auto const r_rows{ right.data() };
+	if ((kind == Join::inner) && (right.size() > left.size())) {
+		Hash_table<L, U> const table{ l_rows, left.size(), l_ptr };
+		for_each_block(right.size(), [&](size_t start, size_t end) {
+			for (auto j{ start }; j < end; ++j)
+				table.for_each_match(r_rows[j].*r_ptr, [&](size_t i) { f(start, i, j); });
+		});
+		return true;
+	}
+	Hash_table<R, V> const table{ r_rows, right.size(), r_ptr };
+	for_each_block(left.size(), [&](size_t start, size_t end) {
+		for (auto i{ start }; i < end; ++i) {
+			bool matched{ false };
+			table.for_each_match(l_rows[i].*l_ptr, [&](size_t j) { matched = true, f(start, i, j); });
+			if (!matched && (kind == Join::left))
+				f(start, i, npos);
+		}
+	});
+	return false;
+}
+} // namespace internals
+
+template<typename Left, typename L, typename Right, typename R, typename U, typename V, typename F>
+void
+join(Left const& left, U L::*l_ptr, Right const& right, V R::*r_ptr, Join kind, F const& f)
+{
+	internals::join_blocks(
+	  left, l_ptr, right, r_ptr, kind, [&](size_t, size_t i, size_t j) { f(i, j); });
+}
+template<typename Left, typename L, typename Right, typename R, typename U, typename V>
+std::vector<std::pair<size_t, size_t>>
+join(Left const& left, U L::*l_ptr, Right const& right, V R::*r_ptr, Join kind = Join::inner)
+{
+	auto const n{ std::max(left.size(), right.size()) };
+	std::vector<std::vector<std::pair<size_t, size_t>>> parts((n + chunk_rows - 1) / chunk_rows);
+	auto const probed_right{ internals::join_blocks(
+	  left, l_ptr, right, r_ptr, kind, [&](size_t start, size_t i, size_t j) {
+		  parts[start / chunk_rows].emplace_back(i, j);
+	  }) };
+	std::vector<std::pair<size_t, size_t>> rvo;
+	for (auto const& part : parts)
+		rvo.insert(end(rvo), begin(part), end(part));
+	if (probed_right)
+		parallel_sort(rvo, std::less<std::pair<size_t, size_t>>{});
+	return rvo;
+}
+
+// std::cout << freq(table, &Row::member, name);
+// The numbers are in increasing order, the missing ones last. The strings keep the order of
+// std::array, used by freq before group_by: the chars are compared as signed, so the missing
+// string (null chars) comes after the non-ASCII ones but before the others.
+template<typename T, typename A, typename U>
 std::string
-freq(std::vector<T> const& table, U T::*m_ptr, std::string const& name)
+freq(std::vector<T, A> const& table, U T::*m_ptr, std::string const& name)
 {
 	std::string rvo{ "Freq of " + name + ".\n" };
 	if (table.empty())
 		rvo += "<empty table>\n";
 	else {
-		std::map<U, size_t> freq;
-		for (auto const& row : table)
-			++freq[row.*m_ptr];
-		for (auto const& p : freq) {
-			auto const pct{ size_t(100. * p.second / table.size()) };
-			rvo += (missing(p.first) ? std::string("-.-") : std::to_string(p.first)) + '\t' +
-			       std::to_string(p.second) + '\t' + (pct ? std::to_string(pct) : std::string("𝜀")) +
+		auto groups{ group_by(table, keys(m_ptr)) };
+		if constexpr (!std::is_arithmetic_v<U>)
+			std::sort(begin(groups), end(groups), [](auto const& a, auto const& b) {
+				return std::get<0>(a.key) < std::get<0>(b.key);
+			});
+		for (auto const& group : groups) {
+			auto const& u{ std::get<0>(group.key) };
+			auto const pct{ size_t(100. * group.n / table.size()) };
+			rvo += (missing(u) ? std::string("-.-") : std::to_string(u)) + '\t' +
+			       std::to_string(group.n) + '\t' + (pct ? std::to_string(pct) : std::string("𝜀")) +
 			       '\n';
 		}
 	}